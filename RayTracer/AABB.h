@@ -0,0 +1,104 @@
+#ifndef __AABB_H__
+#define __AABB_H__
+
+#include <limits>
+
+#include "Common.h"
+#include "Ray.h"
+
+// ----------------------------------------------------------------------------
+
+// Axis aligned bounding box
+struct AABB
+{
+	AABB()
+		: Min(glm::vec3(std::numeric_limits<float>::max())),
+		Max(glm::vec3(std::numeric_limits<float>::lowest()))
+	{ }
+
+	AABB(const glm::vec3& vMin, const glm::vec3& vMax)
+		: Min(vMin), Max(vMax)
+	{ }
+
+	// ------------------------------------------------------------------------
+
+	inline void Extend(const glm::vec3& point)
+	{
+		Min = glm::min(Min, point);
+		Max = glm::max(Max, point);
+	}
+
+	inline void Extend(const AABB& box)
+	{
+		Min = glm::min(Min, box.Min);
+		Max = glm::max(Max, box.Max);
+	}
+
+	// ------------------------------------------------------------------------
+
+	inline bool IsValid() const
+	{
+		return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z;
+	}
+
+	inline bool operator==(const AABB& other) const
+	{
+		return Min == other.Min && Max == other.Max;
+	}
+
+	inline bool operator!=(const AABB& other) const { return !(*this == other); }
+
+	inline glm::vec3 Centroid() const { return (Min + Max) * 0.5f; }
+	inline glm::vec3 Extent() const { return Max - Min; }
+
+	inline float SurfaceArea() const
+	{
+		if (IsValid() == false)
+		{
+			return 0.0f;
+		}
+
+		glm::vec3 extent = Max - Min;
+		return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+	}
+
+	inline unsigned int LongestAxis() const
+	{
+		glm::vec3 extent = Max - Min;
+		if (extent.x > extent.y && extent.x > extent.z) return 0;
+		if (extent.y > extent.z) return 1;
+		return 2;
+	}
+
+	// ------------------------------------------------------------------------
+
+	// Slab test. The ray's reciprocal direction is passed in so it can be
+	// computed once per ray instead of once per box.
+	inline bool Intersect(const glm::vec3& origin,
+		const glm::vec3& invDirection,
+		float tMax,
+		float& tNear) const
+	{
+		glm::vec3 t0 = (Min - origin) * invDirection;
+		glm::vec3 t1 = (Max - origin) * invDirection;
+
+		glm::vec3 tSmall = glm::min(t0, t1);
+		glm::vec3 tBig = glm::max(t0, t1);
+
+		float tEnter = glm::max(glm::max(tSmall.x, tSmall.y), glm::max(tSmall.z, 0.0f));
+		float tExit = glm::min(glm::min(tBig.x, tBig.y), glm::min(tBig.z, tMax));
+
+		tNear = tEnter;
+
+		return tEnter <= tExit;
+	}
+
+	// ------------------------------------------------------------------------
+
+	glm::vec3 Min;
+	glm::vec3 Max;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __AABB_H__
\ No newline at end of file
@@ -2,10 +2,9 @@
 #define __AREALIGHT_H__
 
 #include "Light.h"
-#include "Triangle.h"
-#include "Box.h"
+#include "BoxShape.h"
 
-#include <vector>
+#include <limits>
 
 class AreaLight : public Light
 {
@@ -58,27 +57,32 @@ public:
 		return glm::vec3(m_fMinX, m_fMinY, m_fMinZ);
 	}
 
+	// Point on the lower face of the light for a sample in the unit square
+	inline glm::vec3 GetSamplePoint(const glm::vec2& sample)
+	{
+		return glm::vec3(m_fMinX + sample.x * m_fLength,
+			m_fMinY - Constants::EPS,
+			m_fMinZ + sample.y * m_fDepth);
+	}
+
 	inline IntersectionInfo FindIntersection(const Ray& ray)
 	{
-		// Check for collision against all triangles in the area light
-		for (Triangle& tri : m_vTriangleList)
+		float t;
+		glm::vec3 normal;
+
+		if (m_Shape.Intersect(ray, std::numeric_limits<float>::infinity(), t, normal) == false)
 		{
-			IntersectionInfo intersect;
-
-			if (tri.RayTriangleIntersect(ray,
-				intersect.NormalAtIntersection,
-				intersect.IntersectionPoint,
-				intersect.RayLength))
-			{
-				intersect.HitObject = this;
-				intersect.NormalAtIntersection = -intersect.NormalAtIntersection;
-
-				return intersect;
-			}
+			// Nothing was hit
+			return IntersectionInfo(vec3(0.0f), -1.0f, vec3(0.0f), NULL);
 		}
 
-		// Nothing was hit
-		return IntersectionInfo(vec3(0.0f), -1.0f, vec3(0.0f), NULL);
+		return IntersectionInfo(ray.GetOrigin() + t * ray.GetDirection(), t, normal, this);
+	}
+
+	inline bool GetBoundingBox(AABB& bounds) override
+	{
+		bounds = AABB(glm::vec3(m_fMinX, m_fMinY, m_fMinZ), glm::vec3(m_fMaxX, m_fMaxY, m_fMaxZ));
+		return true;
 	}
 
 	inline glm::vec3 GetPosition() { return Position; }
@@ -87,8 +91,8 @@ public:
 		// Update position
 		Position = newPosition;
 
-		// Generate the triangles and calculate the extreme points
-		GenerateTriangles(Position, m_fLength, m_fHeight, m_fDepth);
+		// Move the box and calculate the extreme points
+		UpdateShape(Position, m_fLength, m_fHeight, m_fDepth);
 	}
 
 	inline const float GetLength() const { return m_fLength; }
@@ -117,7 +121,7 @@ public:
 	sf::Color SpecularLight;
 
 private:
-	std::vector<Triangle> m_vTriangleList;
+	BoxShape m_Shape;
 
 	float m_fLength;
 	float m_fDepth;
@@ -140,20 +144,8 @@ private:
 
 	// ---------------------------------------------------------------------------
 
-	void GenerateTriangles(const glm::vec3& pos, float length, float height, float depth)
+	void UpdateShape(const glm::vec3& pos, float length, float height, float depth)
 	{
-		m_vTriangleList.clear();
-
-		// Calculate the coordinates of the box
-		glm::vec3 p1 = glm::vec3(pos.x - length / 2.0f, pos.y - height / 2.0f, pos.z - depth / 2.0f);
-		glm::vec3 p2 = glm::vec3(pos.x + length / 2.0f, pos.y - height / 2.0f, pos.z - depth / 2.0f);
-		glm::vec3 p3 = glm::vec3(pos.x + length / 2.0f, pos.y + height / 2.0f, pos.z - depth / 2.0f);
-		glm::vec3 p4 = glm::vec3(pos.x - length / 2.0f, pos.y + height / 2.0f, pos.z - depth / 2.0f);
-		glm::vec3 p5 = glm::vec3(pos.x - length / 2.0f, pos.y - height / 2.0f, pos.z + depth / 2.0f);
-		glm::vec3 p6 = glm::vec3(pos.x + length / 2.0f, pos.y - height / 2.0f, pos.z + depth / 2.0f);
-		glm::vec3 p7 = glm::vec3(pos.x + length / 2.0f, pos.y + height / 2.0f, pos.z + depth / 2.0f);
-		glm::vec3 p8 = glm::vec3(pos.x - length / 2.0f, pos.y + height / 2.0f, pos.z + depth / 2.0f);
-
 		m_fMinX = pos.x - length / 2.0f;
 		m_fMaxX = pos.x + length / 2.0f;
 
@@ -172,45 +164,9 @@ private:
 		m_fSampleSize_X = m_fLength / m_uiSampleCount_X;
 		m_fSampleSize_Z = m_fDepth / m_uiSampleCount_Z;
 
-		// Add the triangles to the list of triangles
-
-		// CCW
-		// Front face
-		m_vTriangleList.push_back(Triangle(p1, p2, p4)); m_vTriangleList.push_back(Triangle(p2, p3, p4));
-
-		// Right face
-		m_vTriangleList.push_back(Triangle(p2, p6, p3)); m_vTriangleList.push_back(Triangle(p6, p7, p3));
-
-		// Back face
-		m_vTriangleList.push_back(Triangle(p6, p5, p7)); m_vTriangleList.push_back(Triangle(p5, p8, p7));
-
-		// Left face
-		m_vTriangleList.push_back(Triangle(p5, p1, p8)); m_vTriangleList.push_back(Triangle(p1, p4, p8));
-
-		// Top face
-		m_vTriangleList.push_back(Triangle(p4, p3, p8)); m_vTriangleList.push_back(Triangle(p3, p7, p8));
-
-		// Bottom face
-		m_vTriangleList.push_back(Triangle(p5, p6, p1)); m_vTriangleList.push_back(Triangle(p6, p2, p1));
-
-		// CW
-		//// Front face
-		//m_vTriangleList.push_back(Triangle(p1, p4, p2)); m_vTriangleList.push_back(Triangle(p2, p4, p3));
-
-		//// Right face
-		//m_vTriangleList.push_back(Triangle(p2, p3, p6)); m_vTriangleList.push_back(Triangle(p6, p3, p7));
-
-		//// Back face
-		//m_vTriangleList.push_back(Triangle(p6, p7, p5)); m_vTriangleList.push_back(Triangle(p5, p7, p8));
-
-		//// Left face
-		//m_vTriangleList.push_back(Triangle(p5, p8, p1)); m_vTriangleList.push_back(Triangle(p1, p8, p4));
-
-		//// Top face
-		//m_vTriangleList.push_back(Triangle(p4, p8, p3)); m_vTriangleList.push_back(Triangle(p3, p8, p7));
-
-		//// Bottom face
-		//m_vTriangleList.push_back(Triangle(p5, p1, p6)); m_vTriangleList.push_back(Triangle(p6, p1, p2));
+		// The light is rendered as an axis aligned box
+		m_Shape.SetCenter(pos);
+		m_Shape.SetHalfSize(glm::vec3(m_fLength, m_fHeight, m_fDepth) * 0.5f);
 	}
 };
 
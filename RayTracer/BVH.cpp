@@ -0,0 +1,498 @@
+// -----------------------------------------------------------------------
+
+#include "BVH.h"
+
+#include <algorithm>
+#include <numeric>
+
+#ifdef BVH_AVX2
+#include <immintrin.h>
+#endif
+
+// -----------------------------------------------------------------------
+
+namespace
+{
+	// Number of buckets used to evaluate split candidates along an axis
+	const unsigned int SAH_BIN_COUNT = 16;
+
+	// Relative cost of visiting an inner node compared to testing a primitive
+	const float SAH_TRAVERSAL_COST = 1.0f;
+
+	// Past this depth the builder falls back to median splits which keeps the
+	// hierarchy shallow enough for the fixed size traversal stack
+	const unsigned int SAH_MAX_DEPTH = 64;
+
+	struct SAHBin
+	{
+		AABB Bounds;
+		unsigned int Count = 0;
+	};
+}
+
+// -----------------------------------------------------------------------
+
+void BVH::Build(const std::vector<AABB>& primitiveBounds, unsigned int uiMaxLeafSize, bool bBatchedLeaves)
+{
+	Clear();
+
+	m_uiMaxLeafSize = std::max(uiMaxLeafSize, 1u);
+	m_bBatchedLeaves = bBatchedLeaves;
+
+	unsigned int uiPrimitiveCount = (unsigned int)primitiveBounds.size();
+	if (uiPrimitiveCount == 0)
+	{
+		return;
+	}
+
+	// Keep a copy of the bounds, refitting a leaf needs all of its primitives
+	m_vPrimitiveBounds = primitiveBounds;
+	m_vPrimitiveLeaf.assign(uiPrimitiveCount, -1);
+
+	// Initialize the primitive list and cache the centroids
+	m_vPrimitiveIndices.resize(uiPrimitiveCount);
+	std::iota(m_vPrimitiveIndices.begin(), m_vPrimitiveIndices.end(), 0u);
+
+	std::vector<glm::vec3> centroids(uiPrimitiveCount);
+	for (unsigned int index = 0; index < uiPrimitiveCount; index++)
+	{
+		centroids[index] = primitiveBounds[index].Centroid();
+	}
+
+	// A binary tree with N leaves has at most 2N - 1 nodes
+	m_vNodes.reserve(2 * uiPrimitiveCount - 1);
+	m_vNodes.push_back(BVHNode());
+
+	BuildNode(0, 0, uiPrimitiveCount, 0, primitiveBounds, centroids);
+
+	// Remember which leaf holds each primitive and the initial tree cost
+	m_fNodeCost = 0.0f;
+	for (const BVHNode& node : m_vNodes)
+	{
+		m_fNodeCost += node.Bounds.SurfaceArea() * NodeCostWeight(node);
+
+		for (unsigned int index = 0; index < node.PrimitiveCount; index++)
+		{
+			m_vPrimitiveLeaf[m_vPrimitiveIndices[node.FirstPrimitive + index]] = (int)(&node - &m_vNodes[0]);
+		}
+	}
+
+	m_fBuildCost = SAHCost();
+
+	BuildWideNodes();
+}
+
+// -----------------------------------------------------------------------
+
+float BVH::NodeCostWeight(const BVHNode& node) const
+{
+	if (node.IsLeaf())
+	{
+		return m_bBatchedLeaves ? 1.0f : (float)node.PrimitiveCount;
+	}
+
+	return SAH_TRAVERSAL_COST;
+}
+
+// -----------------------------------------------------------------------
+
+void BVH::UpdatePrimitiveBounds(unsigned int uiPrimitive, const AABB& bounds)
+{
+	if (uiPrimitive >= m_vPrimitiveBounds.size() ||
+		m_vPrimitiveBounds[uiPrimitive] == bounds)
+	{
+		return;
+	}
+
+	m_vPrimitiveBounds[uiPrimitive] = bounds;
+	m_vDirtyLeaves.push_back(m_vPrimitiveLeaf[uiPrimitive]);
+}
+
+// -----------------------------------------------------------------------
+
+void BVH::Refit()
+{
+	if (m_vDirtyLeaves.empty())
+	{
+		return;
+	}
+
+	for (int iLeafIndex : m_vDirtyLeaves)
+	{
+		// Recompute the bounds of the leaf from its primitives
+		BVHNode& leaf = m_vNodes[iLeafIndex];
+
+		AABB leafBounds;
+		for (unsigned int index = 0; index < leaf.PrimitiveCount; index++)
+		{
+			leafBounds.Extend(m_vPrimitiveBounds[m_vPrimitiveIndices[leaf.FirstPrimitive + index]]);
+		}
+
+		if (leafBounds == leaf.Bounds)
+		{
+			continue;
+		}
+
+		m_fNodeCost += (leafBounds.SurfaceArea() - leaf.Bounds.SurfaceArea()) * NodeCostWeight(leaf);
+		leaf.Bounds = leafBounds;
+		RefitWideSlot(leaf);
+
+		// Walk up to the root. Stop as soon as a node's bounds don't change,
+		// its ancestors are then unaffected by this leaf.
+		int iNodeIndex = leaf.Parent;
+		while (iNodeIndex != -1)
+		{
+			BVHNode& node = m_vNodes[iNodeIndex];
+
+			AABB nodeBounds = m_vNodes[node.Left].Bounds;
+			nodeBounds.Extend(m_vNodes[node.Right].Bounds);
+
+			if (nodeBounds == node.Bounds)
+			{
+				break;
+			}
+
+			m_fNodeCost += (nodeBounds.SurfaceArea() - node.Bounds.SurfaceArea()) * NodeCostWeight(node);
+			node.Bounds = nodeBounds;
+			RefitWideSlot(node);
+
+			iNodeIndex = node.Parent;
+		}
+	}
+
+	m_vDirtyLeaves.clear();
+}
+
+// -----------------------------------------------------------------------
+
+void BVH::BuildWideNodes()
+{
+	m_vWideNodes.clear();
+
+#ifdef BVH_AVX2
+	m_vWideNodes8.clear();
+	m_bWide8 = CpuSupportsAVX2();
+
+	if (m_bWide8)
+	{
+		BuildWideNodes(m_vWideNodes8);
+		return;
+	}
+#endif
+
+	BuildWideNodes(m_vWideNodes);
+}
+
+// -----------------------------------------------------------------------
+
+template <typename WideNodeType>
+void BVH::BuildWideNodes(std::vector<WideNodeType>& wideNodes)
+{
+	if (m_vNodes.empty())
+	{
+		return;
+	}
+
+	// Every wide node replaces at least one inner binary node
+	wideNodes.reserve(m_vNodes.size() / 2 + 1);
+
+	if (m_vNodes[0].IsLeaf())
+	{
+		// Single leaf tree, the root holds it in its first slot
+		WideNodeType root;
+		root.SetChildBounds(0, m_vNodes[0].Bounds);
+		root.Child[0] = 0;
+		root.LeafMask = 1;
+		m_vNodes[0].WideNode = 0;
+		m_vNodes[0].WideSlot = 0;
+
+		wideNodes.push_back(root);
+		return;
+	}
+
+	CollapseNode(wideNodes, 0);
+}
+
+// -----------------------------------------------------------------------
+
+template <typename WideNodeType>
+int BVH::CollapseNode(std::vector<WideNodeType>& wideNodes, int iBinaryNodeIndex)
+{
+	const BVHNode& binaryNode = m_vNodes[iBinaryNodeIndex];
+
+	// Start from the two children and keep opening the inner child with the
+	// largest surface area, the one most likely to be hit, until the node is
+	// full or only leaves are left
+	int children[WideNodeType::WIDTH] = { binaryNode.Left, binaryNode.Right };
+	unsigned int uiChildCount = 2;
+
+	while (uiChildCount < WideNodeType::WIDTH)
+	{
+		int iBestSlot = -1;
+		float fBestArea = -1.0f;
+
+		for (unsigned int uiSlot = 0; uiSlot < uiChildCount; uiSlot++)
+		{
+			const BVHNode& child = m_vNodes[children[uiSlot]];
+			if (child.IsLeaf() == false && child.Bounds.SurfaceArea() > fBestArea)
+			{
+				iBestSlot = (int)uiSlot;
+				fBestArea = child.Bounds.SurfaceArea();
+			}
+		}
+
+		if (iBestSlot < 0)
+		{
+			break;
+		}
+
+		const BVHNode& opened = m_vNodes[children[iBestSlot]];
+		children[iBestSlot] = opened.Left;
+		children[uiChildCount++] = opened.Right;
+	}
+
+	int iWideNodeIndex = (int)wideNodes.size();
+	wideNodes.push_back(WideNodeType());
+
+	for (unsigned int uiSlot = 0; uiSlot < uiChildCount; uiSlot++)
+	{
+		BVHNode& child = m_vNodes[children[uiSlot]];
+		child.WideNode = iWideNodeIndex;
+		child.WideSlot = uiSlot;
+
+		// The vector grows while collapsing the children, so the node is
+		// looked up again for every slot
+		int iChild = child.IsLeaf() ? children[uiSlot] : CollapseNode(wideNodes, children[uiSlot]);
+
+		WideNodeType& wideNode = wideNodes[iWideNodeIndex];
+		wideNode.SetChildBounds(uiSlot, child.Bounds);
+		wideNode.Child[uiSlot] = iChild;
+		wideNode.LeafMask |= child.IsLeaf() ? (1u << uiSlot) : 0u;
+	}
+
+	return iWideNodeIndex;
+}
+
+#ifdef BVH_AVX2
+
+// -----------------------------------------------------------------------
+
+unsigned int BVH::IntersectChildren(const WideBVHNode8& node,
+	const WideRay& ray,
+	float tMax,
+	float tNear[WideBVHNode8::WIDTH])
+{
+	// Same operations as the SSE2 test of the 4-wide nodes, see there
+	__m256 tEnter = _mm256_setzero_ps();
+	__m256 tExit = _mm256_set1_ps(tMax);
+
+	for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+	{
+		__m256 origin = _mm256_broadcastss_ps(ray.Origin[uiAxis]);
+		__m256 invDirection = _mm256_broadcastss_ps(ray.InvDirection[uiAxis]);
+
+		__m256 tAxisNear = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(node.Bounds[ray.NearRow[uiAxis]]), origin), invDirection);
+		__m256 tAxisFar = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(node.Bounds[ray.FarRow[uiAxis]]), origin), invDirection);
+
+		tEnter = _mm256_max_ps(tAxisNear, tEnter);
+		tExit = _mm256_min_ps(tAxisFar, tExit);
+	}
+
+	_mm256_storeu_ps(tNear, tEnter);
+	return (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(tEnter, tExit, _CMP_LE_OQ));
+}
+
+// -----------------------------------------------------------------------
+
+unsigned int BVH::IntersectChildrenPacket(const WideBVHNode8& node,
+	const WidePacket& packet,
+	float tMax,
+	float tNear[WideBVHNode8::WIDTH])
+{
+	__m256 tEnter = _mm256_setzero_ps();
+	__m256 tExit = _mm256_set1_ps(tMax);
+
+	for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+	{
+		__m256 origin = _mm256_broadcastss_ps(packet.Origin[uiAxis]);
+		__m256 invDirectionMin = _mm256_broadcastss_ps(packet.InvDirectionMin[uiAxis]);
+		__m256 invDirectionMax = _mm256_broadcastss_ps(packet.InvDirectionMax[uiAxis]);
+
+		__m256 nearDistance = _mm256_sub_ps(_mm256_loadu_ps(node.Bounds[packet.NearRow[uiAxis]]), origin);
+		__m256 farDistance = _mm256_sub_ps(_mm256_loadu_ps(node.Bounds[packet.FarRow[uiAxis]]), origin);
+
+		__m256 tAxisNear = _mm256_min_ps(_mm256_mul_ps(nearDistance, invDirectionMin), _mm256_mul_ps(nearDistance, invDirectionMax));
+		__m256 tAxisFar = _mm256_max_ps(_mm256_mul_ps(farDistance, invDirectionMin), _mm256_mul_ps(farDistance, invDirectionMax));
+
+		tEnter = _mm256_max_ps(tAxisNear, tEnter);
+		tExit = _mm256_min_ps(tAxisFar, tExit);
+	}
+
+	_mm256_storeu_ps(tNear, tEnter);
+	return (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(tEnter, tExit, _CMP_LE_OQ));
+}
+
+#endif
+
+// -----------------------------------------------------------------------
+
+void BVH::BuildNode(int iNodeIndex,
+	unsigned int uiStart,
+	unsigned int uiEnd,
+	unsigned int uiDepth,
+	const std::vector<AABB>& primitiveBounds,
+	const std::vector<glm::vec3>& centroids)
+{
+	// Calculate the bounds of the node and of the primitive centroids
+	AABB nodeBounds;
+	AABB centroidBounds;
+	for (unsigned int index = uiStart; index < uiEnd; index++)
+	{
+		nodeBounds.Extend(primitiveBounds[m_vPrimitiveIndices[index]]);
+		centroidBounds.Extend(centroids[m_vPrimitiveIndices[index]]);
+	}
+
+	m_vNodes[iNodeIndex].Bounds = nodeBounds;
+
+	unsigned int uiCount = uiEnd - uiStart;
+
+	// Single primitive => leaf
+	if (uiCount == 1)
+	{
+		m_vNodes[iNodeIndex].FirstPrimitive = uiStart;
+		m_vNodes[iNodeIndex].PrimitiveCount = uiCount;
+		return;
+	}
+
+	unsigned int uiAxis = centroidBounds.LongestAxis();
+	float fAxisMin = centroidBounds.Min[uiAxis];
+	float fAxisExtent = centroidBounds.Max[uiAxis] - fAxisMin;
+
+	unsigned int uiMid = uiStart + uiCount / 2;
+
+	if (fAxisExtent > 0.0f && uiDepth < SAH_MAX_DEPTH)
+	{
+		// --------------------------------------------------------------------
+		// Bin the centroids along the longest axis
+
+		SAHBin bins[SAH_BIN_COUNT];
+		float fBinScale = SAH_BIN_COUNT / fAxisExtent;
+
+		for (unsigned int index = uiStart; index < uiEnd; index++)
+		{
+			unsigned int uiPrimitive = m_vPrimitiveIndices[index];
+			unsigned int uiBin = std::min((unsigned int)((centroids[uiPrimitive][uiAxis] - fAxisMin) * fBinScale), SAH_BIN_COUNT - 1);
+
+			bins[uiBin].Count++;
+			bins[uiBin].Bounds.Extend(primitiveBounds[uiPrimitive]);
+		}
+
+		// --------------------------------------------------------------------
+		// Sweep the bins from both sides to evaluate every split plane
+
+		float rightArea[SAH_BIN_COUNT - 1];
+		unsigned int rightCount[SAH_BIN_COUNT - 1];
+
+		AABB accumulatedBounds;
+		unsigned int uiAccumulatedCount = 0;
+		for (unsigned int bin = SAH_BIN_COUNT - 1; bin > 0; bin--)
+		{
+			accumulatedBounds.Extend(bins[bin].Bounds);
+			uiAccumulatedCount += bins[bin].Count;
+
+			rightArea[bin - 1] = accumulatedBounds.SurfaceArea();
+			rightCount[bin - 1] = uiAccumulatedCount;
+		}
+
+		float fBestCost = std::numeric_limits<float>::max();
+		unsigned int uiBestSplit = 0;
+
+		accumulatedBounds = AABB();
+		uiAccumulatedCount = 0;
+		for (unsigned int split = 0; split < SAH_BIN_COUNT - 1; split++)
+		{
+			accumulatedBounds.Extend(bins[split].Bounds);
+			uiAccumulatedCount += bins[split].Count;
+
+			if (uiAccumulatedCount == 0 || rightCount[split] == 0)
+			{
+				continue;
+			}
+
+			float fCost = accumulatedBounds.SurfaceArea() * uiAccumulatedCount +
+				rightArea[split] * rightCount[split];
+
+			if (fCost < fBestCost)
+			{
+				fBestCost = fCost;
+				uiBestSplit = split;
+			}
+		}
+
+		// --------------------------------------------------------------------
+		// Compare against the cost of making this node a leaf
+
+		float fNodeArea = nodeBounds.SurfaceArea();
+		float fSplitCost = SAH_TRAVERSAL_COST + (fNodeArea > 0.0f ? fBestCost / fNodeArea : 0.0f);
+		float fLeafCost = m_bBatchedLeaves ? 1.0f : (float)uiCount;
+
+		if (uiCount <= m_uiMaxLeafSize && fLeafCost <= fSplitCost)
+		{
+			m_vNodes[iNodeIndex].FirstPrimitive = uiStart;
+			m_vNodes[iNodeIndex].PrimitiveCount = uiCount;
+			return;
+		}
+
+		// Partition the primitives around the chosen split plane
+		unsigned int* pMid = std::partition(&m_vPrimitiveIndices[uiStart],
+			&m_vPrimitiveIndices[0] + uiEnd,
+			[&](unsigned int uiPrimitive)
+		{
+			unsigned int uiBin = std::min((unsigned int)((centroids[uiPrimitive][uiAxis] - fAxisMin) * fBinScale), SAH_BIN_COUNT - 1);
+			return uiBin <= uiBestSplit;
+		});
+
+		uiMid = (unsigned int)(pMid - &m_vPrimitiveIndices[0]);
+	}
+	else
+	{
+		// ------------------------------------------------------------------------
+		// Centroids are coincident or the tree is too deep => median split
+
+		if (uiCount <= m_uiMaxLeafSize)
+		{
+			m_vNodes[iNodeIndex].FirstPrimitive = uiStart;
+			m_vNodes[iNodeIndex].PrimitiveCount = uiCount;
+			return;
+		}
+
+		std::nth_element(&m_vPrimitiveIndices[uiStart],
+			&m_vPrimitiveIndices[uiMid],
+			&m_vPrimitiveIndices[0] + uiEnd,
+			[&](unsigned int a, unsigned int b) { return centroids[a][uiAxis] < centroids[b][uiAxis]; });
+	}
+
+	if (uiMid == uiStart || uiMid == uiEnd)
+	{
+		uiMid = uiStart + uiCount / 2;
+	}
+
+	// ------------------------------------------------------------------------
+	// Create the children
+
+	int iLeft = (int)m_vNodes.size();
+	int iRight = iLeft + 1;
+	m_vNodes.push_back(BVHNode());
+	m_vNodes.push_back(BVHNode());
+
+	m_vNodes[iNodeIndex].Left = iLeft;
+	m_vNodes[iNodeIndex].Right = iRight;
+	m_vNodes[iNodeIndex].Axis = uiAxis;
+	m_vNodes[iLeft].Parent = iNodeIndex;
+	m_vNodes[iRight].Parent = iNodeIndex;
+
+	BuildNode(iLeft, uiStart, uiMid, uiDepth + 1, primitiveBounds, centroids);
+	BuildNode(iRight, uiMid, uiEnd, uiDepth + 1, primitiveBounds, centroids);
+}
+
+// -----------------------------------------------------------------------
\ No newline at end of file
@@ -0,0 +1,727 @@
+#ifndef __BVH_H__
+#define __BVH_H__
+
+#include <vector>
+
+#include "Common.h"
+#include "Ray.h"
+#include "AABB.h"
+#include "RayPacket.h"
+#include "CpuFeatures.h"
+
+// The children of a wide node are tested with SSE2 on every x86 target and
+// with plain floats everywhere else. x86 builds also get 8-wide nodes tested
+// with AVX2, used instead when the CPU supports it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BVH_SSE2
+#include <emmintrin.h>
+#if defined(CPU_X86)
+#define BVH_AVX2
+#endif
+#endif
+
+// ----------------------------------------------------------------------------
+
+struct BVHNode
+{
+	BVHNode()
+		: Parent(-1), Left(-1), Right(-1), Axis(0), FirstPrimitive(0), PrimitiveCount(0), WideNode(-1), WideSlot(0)
+	{ }
+
+	inline bool IsLeaf() const { return PrimitiveCount > 0; }
+
+	AABB Bounds;
+
+	int Parent;
+	int Left;
+	int Right;
+	unsigned int Axis;
+
+	// Range in the primitive index list (leaves only)
+	unsigned int FirstPrimitive;
+	unsigned int PrimitiveCount;
+
+	// Wide node and slot made from this node, -1 for the nodes opened while
+	// collapsing. A refit copies the new bounds there.
+	int WideNode;
+	unsigned int WideSlot;
+};
+
+// ----------------------------------------------------------------------------
+
+// Node of the wide hierarchy collapsed from the binary one. The bounds of
+// the children are stored one component per row, so a ray is tested against
+// all of them at once.
+template <unsigned int Width>
+struct WideBVHNodeT
+{
+	static const unsigned int WIDTH = Width;
+
+	WideBVHNodeT()
+		: LeafMask(0)
+	{
+		for (unsigned int uiSlot = 0; uiSlot < WIDTH; uiSlot++)
+		{
+			// Inverted bounds, never hit by the ordered slab test
+			SetChildBounds(uiSlot, AABB());
+			Child[uiSlot] = -1;
+		}
+	}
+
+	inline void SetChildBounds(unsigned int uiSlot, const AABB& bounds)
+	{
+		for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+		{
+			Bounds[uiAxis][uiSlot] = bounds.Min[uiAxis];
+			Bounds[3 + uiAxis][uiSlot] = bounds.Max[uiAxis];
+		}
+	}
+
+	// Min x, y, z then max x, y, z of every child
+	float Bounds[6][WIDTH];
+
+	// Wide node index of the inner children, binary node index of the leaves
+	int Child[WIDTH];
+
+	// Bit i is set if child i is a leaf
+	unsigned int LeafMask;
+};
+
+typedef WideBVHNodeT<4> WideBVHNode;
+typedef WideBVHNodeT<8> WideBVHNode8;
+
+// ----------------------------------------------------------------------------
+
+// Binary bounding volume hierarchy built with the surface area heuristic.
+// The hierarchy only knows about primitive bounds; the primitives themselves
+// are intersected through the callback passed to Traverse. Rays walk a 4-wide
+// copy of the tree, which has half the depth and tests the children of a node
+// in one SIMD step, or an 8-wide one on CPUs with AVX2; the binary tree is
+// kept for refitting.
+class BVH
+{
+public:
+	BVH() { }
+
+	// Build the hierarchy over the given primitive bounds. The primitive
+	// indices stored in the leaves refer to positions in this list. With
+	// batched leaves the primitives of a leaf are tested together (SIMD), so
+	// a leaf costs the same whatever its size up to uiMaxLeafSize.
+	void Build(const std::vector<AABB>& primitiveBounds, unsigned int uiMaxLeafSize = 4, bool bBatchedLeaves = false);
+
+	inline void Clear()
+	{
+		m_vNodes.clear();
+		m_vWideNodes.clear();
+#ifdef BVH_AVX2
+		m_vWideNodes8.clear();
+		m_bWide8 = false;
+#endif
+		m_vPrimitiveIndices.clear();
+		m_vPrimitiveBounds.clear();
+		m_vPrimitiveLeaf.clear();
+		m_vDirtyLeaves.clear();
+		m_fNodeCost = 0.0f;
+		m_fBuildCost = 0.0f;
+	}
+
+	inline bool Empty() const { return m_vNodes.empty(); }
+
+	// Bounds of all the primitives, invalid for an empty tree
+	inline AABB GetBounds() const { return m_vNodes.empty() ? AABB() : m_vNodes[0].Bounds; }
+
+	inline const std::vector<BVHNode>& Nodes() const { return m_vNodes; }
+	inline const std::vector<unsigned int>& PrimitiveIndices() const { return m_vPrimitiveIndices; }
+
+	// ------------------------------------------------------------------------
+	// Refitting
+
+	// Store the new bounds of a primitive which moved and mark its leaf. The
+	// tree itself isn't touched until Refit is called.
+	void UpdatePrimitiveBounds(unsigned int uiPrimitive, const AABB& bounds);
+
+	// Bounds of a primitive as of the last build or update
+	inline const AABB& GetPrimitiveBounds(unsigned int uiPrimitive) const { return m_vPrimitiveBounds[uiPrimitive]; }
+
+	// Recompute the bounds of the marked leaves and of their ancestors
+	void Refit();
+
+	// SAH cost of the current tree relative to the cost right after the last
+	// build. Refitting keeps the topology so the ratio grows as objects move
+	// away from where they were when the tree was built.
+	inline float QualityRatio() const
+	{
+		return (m_fBuildCost > 0.0f) ? SAHCost() / m_fBuildCost : 1.0f;
+	}
+
+	inline float SAHCost() const
+	{
+		if (m_vNodes.empty())
+		{
+			return 0.0f;
+		}
+
+		float fRootArea = m_vNodes[0].Bounds.SurfaceArea();
+		return (fRootArea > 0.0f) ? m_fNodeCost / fRootArea : 0.0f;
+	}
+
+	// ------------------------------------------------------------------------
+
+	// Walk the hierarchy front to back. The intersector is called as
+	// intersector(primitiveIndex, tMax) for every primitive in a visited leaf;
+	// it shrinks tMax when it finds a closer hit and returns true to stop the
+	// traversal altogether.
+	template <typename PrimitiveIntersector>
+	inline void Traverse(const Ray& ray, float& tMax, PrimitiveIntersector& intersector) const
+	{
+		auto intersectLeaf = [&](int iLeafIndex, float& tMaxLeaf)
+		{
+			const BVHNode& leaf = m_vNodes[iLeafIndex];
+
+			for (unsigned int index = 0; index < leaf.PrimitiveCount; index++)
+			{
+				if (intersector(m_vPrimitiveIndices[leaf.FirstPrimitive + index], tMaxLeaf))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		};
+
+		TraverseLeaves(ray, tMax, intersectLeaf);
+	}
+
+	// Same walk, but the intersector is called once per visited leaf as
+	// intersector(leafNodeIndex, tMax) and tests all of its primitives. The
+	// leaf index is the one of the binary node.
+	template <typename LeafIntersector>
+	inline void TraverseLeaves(const Ray& ray, float& tMax, LeafIntersector& intersector) const
+	{
+#ifdef BVH_AVX2
+		if (m_bWide8)
+		{
+			TraverseWideLeaves(m_vWideNodes8, ray, tMax, intersector);
+			return;
+		}
+#endif
+		TraverseWideLeaves(m_vWideNodes, ray, tMax, intersector);
+	}
+
+	// ------------------------------------------------------------------------
+	// Packets
+
+	// Walk the hierarchy once for all the rays of a coherent packet. The
+	// packet's direction intervals reject the children of a node which none of
+	// its rays can hit, four or eight at a time. The children left keep the range of
+	// rays from the first to the last one which hits their box, so deeper in
+	// the tree only a few neighbouring rays are carried along. The intersector
+	// is called as intersector(primitiveIndex, uiFirst, uiLast) for every
+	// primitive in a visited leaf; it tests the rays uiFirst to uiLast and
+	// shrinks their entries of tMax when it finds closer hits.
+	template <typename PrimitiveIntersector>
+	inline void TraversePacket(const RayPacket& packet, const float* tMax, PrimitiveIntersector& intersector) const
+	{
+		auto intersectLeaf = [&](int iLeafIndex, unsigned int uiFirst, unsigned int uiLast)
+		{
+			const BVHNode& leaf = m_vNodes[iLeafIndex];
+
+			for (unsigned int index = 0; index < leaf.PrimitiveCount; index++)
+			{
+				intersector(m_vPrimitiveIndices[leaf.FirstPrimitive + index], uiFirst, uiLast);
+			}
+		};
+
+		TraversePacketLeaves(packet, tMax, intersectLeaf);
+	}
+
+	// Same walk, the intersector is called once per visited leaf as
+	// intersector(leafNodeIndex, uiFirst, uiLast)
+	template <typename LeafIntersector>
+	inline void TraversePacketLeaves(const RayPacket& packet, const float* tMax, LeafIntersector& intersector) const
+	{
+#ifdef BVH_AVX2
+		if (m_bWide8)
+		{
+			TraversePacketWideLeaves(m_vWideNodes8, packet, tMax, intersector);
+			return;
+		}
+#endif
+		TraversePacketWideLeaves(m_vWideNodes, packet, tMax, intersector);
+	}
+
+	// ------------------------------------------------------------------------
+
+	static const int MAX_STACK_DEPTH = 128;
+
+private:
+	// Inner nodes are stored by index and leaves by the complement of their
+	// binary index, with the distance at which their box is entered
+	struct StackEntry
+	{
+		int Node;
+		float Near;
+	};
+
+	// Packet walks also carry the range of rays which may hit the node
+	struct PacketStackEntry
+	{
+		int Node;
+		float Near;
+		unsigned short First;
+		unsigned short Last;
+	};
+
+	// Walk of TraverseLeaves over the 4 or 8-wide nodes. Up to WIDTH - 1
+	// siblings wait on the stack for every level.
+	template <typename WideNodeType, typename LeafIntersector>
+	inline void TraverseWideLeaves(const std::vector<WideNodeType>& wideNodes, const Ray& ray, float& tMax, LeafIntersector& intersector) const
+	{
+		if (wideNodes.empty())
+		{
+			return;
+		}
+
+		const WideRay wideRay(ray);
+
+		StackEntry nodeStack[(WideNodeType::WIDTH - 1) * MAX_STACK_DEPTH + 1];
+		int iStackSize = 0;
+		nodeStack[iStackSize++] = { 0, 0.0f };
+
+		while (iStackSize > 0)
+		{
+			StackEntry entry = nodeStack[--iStackSize];
+
+			// A closer hit was found since the entry was pushed
+			if (entry.Near > tMax)
+			{
+				continue;
+			}
+
+			if (entry.Node < 0)
+			{
+				if (intersector(~entry.Node, tMax))
+				{
+					return;
+				}
+				continue;
+			}
+
+			const WideNodeType& node = wideNodes[entry.Node];
+
+			float tNear[WideNodeType::WIDTH];
+			unsigned int uiHitMask = IntersectChildren(node, wideRay, tMax, tNear);
+
+			PushHitChildren(node, uiHitMask, tNear, nodeStack, iStackSize);
+		}
+	}
+
+	// Walk of TraversePacketLeaves over the 4 or 8-wide nodes
+	template <typename WideNodeType, typename LeafIntersector>
+	inline void TraversePacketWideLeaves(const std::vector<WideNodeType>& wideNodes, const RayPacket& packet, const float* tMax, LeafIntersector& intersector) const
+	{
+		if (wideNodes.empty() || packet.Count == 0)
+		{
+			return;
+		}
+
+		const WidePacket widePacket(packet);
+
+		WideRay wideRays[RayPacket::MAX_SIZE];
+		for (unsigned int index = 0; index < packet.Count; index++)
+		{
+			wideRays[index] = WideRay(packet.Rays[index]);
+		}
+
+		PacketStackEntry nodeStack[(WideNodeType::WIDTH - 1) * MAX_STACK_DEPTH + 1];
+		int iStackSize = 0;
+		nodeStack[iStackSize++] = { 0, 0.0f, 0, (unsigned short)(packet.Count - 1) };
+
+		while (iStackSize > 0)
+		{
+			PacketStackEntry entry = nodeStack[--iStackSize];
+
+			// Nodes entered past the farthest hit of their rays are skipped
+			float fRangeTMax = MaxElement(tMax + entry.First, entry.Last - entry.First + 1u);
+			if (entry.Near > fRangeTMax)
+			{
+				continue;
+			}
+
+			if (entry.Node < 0)
+			{
+				intersector(~entry.Node, entry.First, entry.Last);
+				continue;
+			}
+
+			const WideNodeType& node = wideNodes[entry.Node];
+
+			float tNear[WideNodeType::WIDTH];
+			unsigned int uiHitMask = IntersectChildrenPacket(node, widePacket, fRangeTMax, tNear);
+			if (uiHitMask == 0)
+			{
+				continue;
+			}
+
+			// Narrow the range of every child to the rays which hit its box,
+			// and enter it at the nearest of their entry distances
+			PacketStackEntry hitChildren[WideNodeType::WIDTH];
+			unsigned int uiRayHitMask = 0;
+
+			for (unsigned int index = entry.First; index <= entry.Last; index++)
+			{
+				float tRayNear[WideNodeType::WIDTH];
+				unsigned int uiRayMask = IntersectChildren(node, wideRays[index], tMax[index], tRayNear) & uiHitMask;
+
+				for (unsigned int uiSlot = 0; uiSlot < WideNodeType::WIDTH; uiSlot++)
+				{
+					if ((uiRayMask & (1u << uiSlot)) == 0)
+					{
+						continue;
+					}
+
+					PacketStackEntry& child = hitChildren[uiSlot];
+					if ((uiRayHitMask & (1u << uiSlot)) == 0)
+					{
+						child.First = (unsigned short)index;
+						child.Near = tRayNear[uiSlot];
+					}
+					child.Last = (unsigned short)index;
+					child.Near = glm::min(child.Near, tRayNear[uiSlot]);
+				}
+
+				uiRayHitMask |= uiRayMask;
+			}
+
+			int iHitCount = 0;
+			for (unsigned int uiSlot = 0; uiSlot < WideNodeType::WIDTH; uiSlot++)
+			{
+				if ((uiRayHitMask & (1u << uiSlot)) != 0)
+				{
+					PacketStackEntry child = hitChildren[uiSlot];
+					child.Node = (node.LeafMask & (1u << uiSlot)) ? ~node.Child[uiSlot] : node.Child[uiSlot];
+					hitChildren[iHitCount++] = child;
+				}
+			}
+
+			PushSorted(hitChildren, iHitCount, nodeStack, iStackSize);
+		}
+	}
+
+	// Push the children which were hit sorted from the farthest to the
+	// nearest, so the nearest one is on top of the stack
+	template <typename WideNodeType>
+	static inline void PushHitChildren(const WideNodeType& node,
+		unsigned int uiHitMask,
+		const float tNear[WideNodeType::WIDTH],
+		StackEntry* pStack,
+		int& iStackSize)
+	{
+		StackEntry hitChildren[WideNodeType::WIDTH];
+		int iHitCount = 0;
+
+		for (unsigned int uiSlot = 0; uiSlot < WideNodeType::WIDTH; uiSlot++)
+		{
+			if ((uiHitMask & (1u << uiSlot)) != 0)
+			{
+				hitChildren[iHitCount++] = { (node.LeafMask & (1u << uiSlot)) ? ~node.Child[uiSlot] : node.Child[uiSlot], tNear[uiSlot] };
+			}
+		}
+
+		PushSorted(hitChildren, iHitCount, pStack, iStackSize);
+	}
+
+	// Insertion sort of a few stack entries from the farthest to the nearest,
+	// pushed in that order
+	template <typename Entry>
+	static inline void PushSorted(Entry* pEntries, int iCount, Entry* pStack, int& iStackSize)
+	{
+		for (int index = 1; index < iCount; index++)
+		{
+			Entry entry = pEntries[index];
+
+			int iInsert = index;
+			while (iInsert > 0 && pEntries[iInsert - 1].Near < entry.Near)
+			{
+				pEntries[iInsert] = pEntries[iInsert - 1];
+				iInsert--;
+			}
+			pEntries[iInsert] = entry;
+		}
+
+		for (int index = 0; index < iCount; index++)
+		{
+			pStack[iStackSize++] = pEntries[index];
+		}
+	}
+
+	static inline float MaxElement(const float* pValues, unsigned int uiCount)
+	{
+		float fMax = -std::numeric_limits<float>::infinity();
+		for (unsigned int index = 0; index < uiCount; index++)
+		{
+			fMax = (pValues[index] > fMax) ? pValues[index] : fMax;
+		}
+		return fMax;
+	}
+
+	// Ray values shared by all the node tests of a traversal
+	struct WideRay
+	{
+		WideRay()
+		{ }
+
+		explicit WideRay(const Ray& ray)
+		{
+			const glm::vec3 invDirection = 1.0f / ray.GetDirection();
+
+			for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+			{
+				// Along a negative direction the max plane is entered first
+				bool bNegative = invDirection[uiAxis] < 0.0f;
+				NearRow[uiAxis] = bNegative ? 3 + uiAxis : uiAxis;
+				FarRow[uiAxis] = bNegative ? uiAxis : 3 + uiAxis;
+
+#ifdef BVH_SSE2
+				Origin[uiAxis] = _mm_set1_ps(ray.GetOrigin()[uiAxis]);
+				InvDirection[uiAxis] = _mm_set1_ps(invDirection[uiAxis]);
+#else
+				Origin[uiAxis] = ray.GetOrigin()[uiAxis];
+				InvDirection[uiAxis] = invDirection[uiAxis];
+#endif
+			}
+		}
+
+#ifdef BVH_SSE2
+		__m128 Origin[3];
+		__m128 InvDirection[3];
+#else
+		float Origin[3];
+		float InvDirection[3];
+#endif
+
+		// Bounds row of the entry and exit plane on every axis
+		unsigned int NearRow[3];
+		unsigned int FarRow[3];
+	};
+
+	// Slab test of the four children of a 4-wide node. Returns the mask of the
+	// children hit before tMax and stores their entry distances. The planes
+	// are taken in ray order instead of sorting the distances, which also
+	// makes the inverted bounds of the unused slots miss.
+	inline unsigned int IntersectChildren(const WideBVHNode& node,
+		const WideRay& ray,
+		float tMax,
+		float tNear[WideBVHNode::WIDTH]) const
+	{
+#ifdef BVH_SSE2
+		// max/min return their second operand when one is NaN (a ray in a
+		// box's plane), so the running bound is always the second one
+		__m128 tEnter = _mm_setzero_ps();
+		__m128 tExit = _mm_set1_ps(tMax);
+
+		for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+		{
+			__m128 tAxisNear = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.Bounds[ray.NearRow[uiAxis]]), ray.Origin[uiAxis]), ray.InvDirection[uiAxis]);
+			__m128 tAxisFar = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.Bounds[ray.FarRow[uiAxis]]), ray.Origin[uiAxis]), ray.InvDirection[uiAxis]);
+
+			tEnter = _mm_max_ps(tAxisNear, tEnter);
+			tExit = _mm_min_ps(tAxisFar, tExit);
+		}
+
+		_mm_storeu_ps(tNear, tEnter);
+		return (unsigned int)_mm_movemask_ps(_mm_cmple_ps(tEnter, tExit));
+#else
+		unsigned int uiHitMask = 0;
+
+		for (unsigned int uiSlot = 0; uiSlot < WideBVHNode::WIDTH; uiSlot++)
+		{
+			float tEnter = 0.0f;
+			float tExit = tMax;
+
+			for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+			{
+				float tAxisNear = (node.Bounds[ray.NearRow[uiAxis]][uiSlot] - ray.Origin[uiAxis]) * ray.InvDirection[uiAxis];
+				float tAxisFar = (node.Bounds[ray.FarRow[uiAxis]][uiSlot] - ray.Origin[uiAxis]) * ray.InvDirection[uiAxis];
+
+				tEnter = (tAxisNear > tEnter) ? tAxisNear : tEnter;
+				tExit = (tAxisFar < tExit) ? tAxisFar : tExit;
+			}
+
+			tNear[uiSlot] = tEnter;
+			uiHitMask |= (tEnter <= tExit) ? (1u << uiSlot) : 0u;
+		}
+
+		return uiHitMask;
+#endif
+	}
+
+	// Packet values shared by all the node tests of a packet traversal
+	struct WidePacket
+	{
+		explicit WidePacket(const RayPacket& packet)
+		{
+			for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+			{
+				// All the rays go the same way on every axis
+				bool bNegative = packet.InvDirectionMax[uiAxis] < 0.0f;
+				NearRow[uiAxis] = bNegative ? 3 + uiAxis : uiAxis;
+				FarRow[uiAxis] = bNegative ? uiAxis : 3 + uiAxis;
+
+#ifdef BVH_SSE2
+				Origin[uiAxis] = _mm_set1_ps(packet.Origin[uiAxis]);
+				InvDirectionMin[uiAxis] = _mm_set1_ps(packet.InvDirectionMin[uiAxis]);
+				InvDirectionMax[uiAxis] = _mm_set1_ps(packet.InvDirectionMax[uiAxis]);
+#else
+				Origin[uiAxis] = packet.Origin[uiAxis];
+				InvDirectionMin[uiAxis] = packet.InvDirectionMin[uiAxis];
+				InvDirectionMax[uiAxis] = packet.InvDirectionMax[uiAxis];
+#endif
+			}
+		}
+
+#ifdef BVH_SSE2
+		__m128 Origin[3];
+		__m128 InvDirectionMin[3];
+		__m128 InvDirectionMax[3];
+#else
+		float Origin[3];
+		float InvDirectionMin[3];
+		float InvDirectionMax[3];
+#endif
+
+		unsigned int NearRow[3];
+		unsigned int FarRow[3];
+	};
+
+	// Interval version of IntersectChildren. The distance to a plane is
+	// bounded over the packet by its distance along the two extreme reciprocal
+	// directions, so a child is kept if the earliest possible entry comes
+	// before the latest possible exit. The entry bound is returned in tNear.
+	inline unsigned int IntersectChildrenPacket(const WideBVHNode& node,
+		const WidePacket& packet,
+		float tMax,
+		float tNear[WideBVHNode::WIDTH]) const
+	{
+#ifdef BVH_SSE2
+		__m128 tEnter = _mm_setzero_ps();
+		__m128 tExit = _mm_set1_ps(tMax);
+
+		for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+		{
+			__m128 nearDistance = _mm_sub_ps(_mm_loadu_ps(node.Bounds[packet.NearRow[uiAxis]]), packet.Origin[uiAxis]);
+			__m128 farDistance = _mm_sub_ps(_mm_loadu_ps(node.Bounds[packet.FarRow[uiAxis]]), packet.Origin[uiAxis]);
+
+			__m128 tAxisNear = _mm_min_ps(_mm_mul_ps(nearDistance, packet.InvDirectionMin[uiAxis]), _mm_mul_ps(nearDistance, packet.InvDirectionMax[uiAxis]));
+			__m128 tAxisFar = _mm_max_ps(_mm_mul_ps(farDistance, packet.InvDirectionMin[uiAxis]), _mm_mul_ps(farDistance, packet.InvDirectionMax[uiAxis]));
+
+			tEnter = _mm_max_ps(tAxisNear, tEnter);
+			tExit = _mm_min_ps(tAxisFar, tExit);
+		}
+
+		_mm_storeu_ps(tNear, tEnter);
+		return (unsigned int)_mm_movemask_ps(_mm_cmple_ps(tEnter, tExit));
+#else
+		unsigned int uiHitMask = 0;
+
+		for (unsigned int uiSlot = 0; uiSlot < WideBVHNode::WIDTH; uiSlot++)
+		{
+			float tEnter = 0.0f;
+			float tExit = tMax;
+
+			for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+			{
+				float fNearDistance = node.Bounds[packet.NearRow[uiAxis]][uiSlot] - packet.Origin[uiAxis];
+				float fFarDistance = node.Bounds[packet.FarRow[uiAxis]][uiSlot] - packet.Origin[uiAxis];
+
+				float tAxisNear = glm::min(fNearDistance * packet.InvDirectionMin[uiAxis], fNearDistance * packet.InvDirectionMax[uiAxis]);
+				float tAxisFar = glm::max(fFarDistance * packet.InvDirectionMin[uiAxis], fFarDistance * packet.InvDirectionMax[uiAxis]);
+
+				tEnter = (tAxisNear > tEnter) ? tAxisNear : tEnter;
+				tExit = (tAxisFar < tExit) ? tAxisFar : tExit;
+			}
+
+			tNear[uiSlot] = tEnter;
+			uiHitMask |= (tEnter <= tExit) ? (1u << uiSlot) : 0u;
+		}
+
+		return uiHitMask;
+#endif
+	}
+
+#ifdef BVH_AVX2
+	// The same two tests for the eight children of an 8-wide node, with AVX2.
+	// Only called when the CPU supports it.
+	CPU_TARGET_AVX2 static unsigned int IntersectChildren(const WideBVHNode8& node,
+		const WideRay& ray,
+		float tMax,
+		float tNear[WideBVHNode8::WIDTH]);
+
+	CPU_TARGET_AVX2 static unsigned int IntersectChildrenPacket(const WideBVHNode8& node,
+		const WidePacket& packet,
+		float tMax,
+		float tNear[WideBVHNode8::WIDTH]);
+#endif
+
+	std::vector<BVHNode> m_vNodes;
+	std::vector<WideBVHNode> m_vWideNodes;
+#ifdef BVH_AVX2
+	// Built instead of the 4-wide nodes on CPUs with AVX2
+	std::vector<WideBVHNode8> m_vWideNodes8;
+	bool m_bWide8 = false;
+#endif
+	std::vector<unsigned int> m_vPrimitiveIndices;
+
+	unsigned int m_uiMaxLeafSize = 4;
+	bool m_bBatchedLeaves = false;
+
+	// Refit data
+	std::vector<AABB> m_vPrimitiveBounds;
+	std::vector<int> m_vPrimitiveLeaf;
+	std::vector<int> m_vDirtyLeaves;
+
+	// Sum of the node areas weighted by their SAH cost, kept up to date while
+	// refitting, and its normalized value after the last build
+	float m_fNodeCost = 0.0f;
+	float m_fBuildCost = 0.0f;
+
+	float NodeCostWeight(const BVHNode& node) const;
+
+	// Build the wide tree from the binary one
+	void BuildWideNodes();
+
+	template <typename WideNodeType>
+	void BuildWideNodes(std::vector<WideNodeType>& wideNodes);
+
+	template <typename WideNodeType>
+	int CollapseNode(std::vector<WideNodeType>& wideNodes, int iBinaryNodeIndex);
+
+	// Copy the bounds of a refitted binary node into its wide slot
+	inline void RefitWideSlot(const BVHNode& node)
+	{
+		if (node.WideNode < 0)
+		{
+			return;
+		}
+
+#ifdef BVH_AVX2
+		if (m_bWide8)
+		{
+			m_vWideNodes8[node.WideNode].SetChildBounds(node.WideSlot, node.Bounds);
+			return;
+		}
+#endif
+		m_vWideNodes[node.WideNode].SetChildBounds(node.WideSlot, node.Bounds);
+	}
+
+	void BuildNode(int iNodeIndex,
+		unsigned int uiStart,
+		unsigned int uiEnd,
+		unsigned int uiDepth,
+		const std::vector<AABB>& primitiveBounds,
+		const std::vector<glm::vec3>& centroids);
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __BVH_H__
\ No newline at end of file
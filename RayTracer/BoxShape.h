@@ -0,0 +1,131 @@
+#ifndef __BOXSHAPE_H__
+#define __BOXSHAPE_H__
+
+#include "Common.h"
+#include "Ray.h"
+#include "AABB.h"
+
+// ----------------------------------------------------------------------------
+
+// Box given by its center, half size and an optional rotation. A ray is
+// intersected with a single slab test in the box's own frame; only the faces
+// the ray enters through are hit, so rays starting inside the box miss it.
+class BoxShape
+{
+public:
+	BoxShape(const glm::vec3& center = glm::vec3(0.0f), const glm::vec3& halfSize = glm::vec3(0.5f))
+		: m_vCenter(center), m_vHalfSize(halfSize), m_Rotation(1.0f), m_bRotated(false)
+	{ }
+
+	inline void SetCenter(const glm::vec3& center) { m_vCenter = center; }
+	inline void SetHalfSize(const glm::vec3& halfSize) { m_vHalfSize = halfSize; }
+
+	// Rotation from the box's frame to the world, an orthonormal matrix
+	inline void SetRotation(const glm::mat3& rotation)
+	{
+		m_Rotation = rotation;
+		m_bRotated = (rotation != glm::mat3(1.0f));
+	}
+
+	inline const glm::vec3& GetCenter() const { return m_vCenter; }
+	inline const glm::vec3& GetHalfSize() const { return m_vHalfSize; }
+	inline const glm::mat3& GetRotation() const { return m_Rotation; }
+
+	inline AABB GetBounds() const
+	{
+		// Extent of the rotated half size along each world axis
+		glm::vec3 extent = m_vHalfSize;
+		if (m_bRotated)
+		{
+			glm::mat3 absRotation(glm::abs(m_Rotation[0]), glm::abs(m_Rotation[1]), glm::abs(m_Rotation[2]));
+			extent = absRotation * m_vHalfSize;
+		}
+
+		return AABB(m_vCenter - extent, m_vCenter + extent);
+	}
+
+	// ------------------------------------------------------------------------
+
+	// Entry distance in [0, tMax) and the outward normal of the entry face
+	inline bool Intersect(const Ray& ray, float tMax, float& t, glm::vec3& normal) const
+	{
+		glm::vec3 origin, direction;
+		ToLocal(ray, origin, direction);
+
+		unsigned int uiAxis;
+		if (Slab(origin, direction, tMax, t, uiAxis) == false)
+		{
+			return false;
+		}
+
+		// The entry face is the one facing against the ray
+		glm::vec3 localNormal(0.0f);
+		localNormal[uiAxis] = (direction[uiAxis] > 0.0f) ? -1.0f : 1.0f;
+
+		normal = m_bRotated ? m_Rotation * localNormal : localNormal;
+		return true;
+	}
+
+	inline bool Occluded(const Ray& ray, float tMax) const
+	{
+		glm::vec3 origin, direction;
+		ToLocal(ray, origin, direction);
+
+		float t;
+		unsigned int uiAxis;
+		return Slab(origin, direction, tMax, t, uiAxis);
+	}
+
+private:
+	glm::vec3 m_vCenter;
+	glm::vec3 m_vHalfSize;
+
+	glm::mat3 m_Rotation;
+	bool m_bRotated;
+
+	// ------------------------------------------------------------------------
+
+	inline void ToLocal(const Ray& ray, glm::vec3& origin, glm::vec3& direction) const
+	{
+		origin = ray.GetOrigin() - m_vCenter;
+		direction = ray.GetDirection();
+
+		if (m_bRotated)
+		{
+			// The inverse of a rotation is its transpose
+			glm::mat3 inverseRotation = glm::transpose(m_Rotation);
+			origin = inverseRotation * origin;
+			direction = inverseRotation * direction;
+		}
+	}
+
+	// Slab test against [-HalfSize, HalfSize] in the box's frame
+	inline bool Slab(const glm::vec3& origin,
+		const glm::vec3& direction,
+		float tMax,
+		float& tNear,
+		unsigned int& uiAxis) const
+	{
+		glm::vec3 invDirection = 1.0f / direction;
+
+		glm::vec3 t0 = (-m_vHalfSize - origin) * invDirection;
+		glm::vec3 t1 = (m_vHalfSize - origin) * invDirection;
+
+		glm::vec3 tEntry = glm::min(t0, t1);
+		glm::vec3 tExit = glm::max(t0, t1);
+
+		// The last slab entered gives the entry face
+		uiAxis = 0;
+		tNear = tEntry.x;
+		if (tEntry.y > tNear) { tNear = tEntry.y; uiAxis = 1; }
+		if (tEntry.z > tNear) { tNear = tEntry.z; uiAxis = 2; }
+
+		float tFar = glm::min(glm::min(tExit.x, tExit.y), tExit.z);
+
+		return tNear <= tFar && tNear >= 0.0f && tNear < tMax;
+	}
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __BOXSHAPE_H__
\ No newline at end of file
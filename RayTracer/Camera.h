@@ -9,7 +9,7 @@ class Camera
 {
 public:
 	Camera(
-		vec3& vPos, 
+		const vec3& vPos, 
 		float fVerticalFieldOfView,
 		float fHorizontalFieldOfView)
 		: m_vCameraPosition(vPos), 
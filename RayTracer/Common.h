@@ -20,8 +20,10 @@ typedef glm::vec3 Point;
 
 typedef glm::vec4 vec4;
 
+// Linear RGB radiance, 1.0 is the brightest displayable value
+typedef glm::vec3 Radiance;
+
 #define rad(x) (x * glm::pi<float>()) / 180.0f
-#define Random() ((float) rand() / (RAND_MAX)) + 1
 
 // -----------------------------------------------------------------------
 
@@ -100,6 +102,13 @@ inline float PolarizedReflection(
 	return reflection;
 }
 
+// -----------------------------------------------------------------------
+
+inline Radiance ToRadiance(const sf::Color& color)
+{
+	return Radiance(color.r, color.g, color.b) * (1.0f / 255.0f);
+}
+
 // -----------------------------------------------------------------------
 // Structs define 
 // -----------------------------------------------------------------------
@@ -0,0 +1,54 @@
+#ifndef __CPUFEATURES_H__
+#define __CPUFEATURES_H__
+
+// Code paths for instruction sets above the compiler's target are built with
+// CPU_TARGET_AVX2 on their functions and only called when the CPU running the
+// program supports them. MSVC accepts the intrinsics of every instruction set
+// without /arch; GCC and Clang need the target on the function itself.
+#if defined(_M_X64) || defined(_M_IX86)
+#define CPU_X86
+#define CPU_TARGET_AVX2
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#define CPU_X86
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// ----------------------------------------------------------------------------
+
+// True if the CPU and the OS support AVX2. The answer is looked up once.
+inline bool CpuSupportsAVX2()
+{
+#if defined(_MSC_VER) && defined(CPU_X86)
+	static const bool bSupported = []()
+	{
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		// AVX and OSXSAVE, then the OS has to save the YMM registers
+		__cpuid(info, 1);
+		const int iAVXBits = (1 << 27) | (1 << 28);
+		if ((info[2] & iAVXBits) != iAVXBits || (_xgetbv(0) & 6) != 6)
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}();
+	return bSupported;
+#elif defined(CPU_X86)
+	static const bool bSupported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") != 0);
+	return bSupported;
+#else
+	return false;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+#endif // __CPUFEATURES_H__
\ No newline at end of file
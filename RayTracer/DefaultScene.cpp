@@ -0,0 +1,194 @@
+#include "DefaultScene.h"
+
+#include <string.h>
+#include <chrono>
+#include <iostream>
+
+#include "Sphere.h"
+#include "Plane.h"
+#include "DirectionalLight.h"
+#include "PointLight.h"
+#include "Triangle.h"
+#include "Box.h"
+#include "Mesh.h"
+
+// -----------------------------------------------------------------------------
+
+sf::Color WhiteColor = sf::Color(255, 255, 255, 255);
+sf::Color BlackColor = sf::Color(0, 0, 0, 255);
+sf::Color RedColor = sf::Color(255, 0, 0, 255);
+sf::Color GreenColor = sf::Color(0, 255, 0, 255);
+sf::Color BlueColor = sf::Color(0, 0, 255, 255);
+
+// -----------------------------------------------------------------------------
+
+std::shared_ptr<Camera> CreateDefaultCamera(unsigned int uiWidth, unsigned int uiHeight)
+{
+	std::shared_ptr<Camera> pCam = std::make_shared<Camera>(glm::vec3(-1.57641f, 2.33531f, -0.256838f),
+		60.0f,
+		60.0f * (uiWidth / (float)uiHeight));
+	pCam->SetXRotation(0.49803f);
+	pCam->SetYRotation(-5.36572f);
+	pCam->UpdateViewMatrix();
+
+	return pCam;
+}
+
+// -----------------------------------------------------------------------------
+
+void CreateDefaultScene(Scene& scene)
+{
+	// Light
+	DirectionalLight* dirLight = new DirectionalLight(
+		glm::vec3(-1.0f, 2.0f, 0.5f),
+		sf::Color(40, 40, 40, 255),
+		sf::Color(40, 40, 40, 255),
+		sf::Color(40, 40, 40, 255),
+		5.0f, 
+		"DirectionalLight1");
+	PointLight* pointLight1 = new PointLight(
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		sf::Color(80, 80, 80, 255),
+		WhiteColor,
+		WhiteColor,
+		glm::vec3(0.0f, 2.0f, 1.0f),
+		5.0f,
+		"PointLightWhite");
+	PointLight* pointLight2 = new PointLight(
+		glm::vec3(4.0f, 1.0f, -3.0f),
+		sf::Color(10, 10, 10, 255),
+		BlueColor,
+		WhiteColor,
+		glm::vec3(1.0f, 4.0f, 1.0f),
+		2.0f,
+		"PointLightBlue");
+	PointLight* pointLight3 = new PointLight(
+		glm::vec3(8.0f, 1.0f, -5.0f),
+		sf::Color(10, 10, 10, 255),
+		RedColor,
+		WhiteColor,
+		glm::vec3(1.0f, 4.0f, 1.0f),
+		2.0f,
+		"PointLightRed");
+
+	// Add area light for soft shadows
+	Triangle triangle1(glm::vec3(0.0f, 5.0f, 0.0f),
+		glm::vec3(1.0f, 5.0f, 0.0f),
+		glm::vec3(0.0f, 5.0f, 1.0f));
+	Triangle triangle2(glm::vec3(0.0f, 5.0f, 1.0f),
+		glm::vec3(1.0f, 5.0f, 0.0f),
+		glm::vec3(1.0f, 5.0f, 1.0f));
+
+	AreaLight* areaLight = new AreaLight(
+		glm::vec3(3.0f, 4.0f, 3.0f),
+		0.8f, 0.1f, 0.8f,
+		WhiteColor, WhiteColor, WhiteColor, "SquareAreaLight");
+
+	// ------------------------------------------------------------------------
+	// Scene
+
+	//scene.AddObject(dirLight);
+	//scene.AddObject(pointLight1);
+	scene.AddObject(areaLight);
+
+	Material sphere1CopperMat;
+	memset(&sphere1CopperMat, 0, sizeof(Material));
+	sphere1CopperMat.Ambient = sf::Color(49, 19, 6, 255);
+	sphere1CopperMat.Diffuse = sf::Color(180, 69, 21, 255);
+	sphere1CopperMat.Specular = sf::Color(65, 35, 22, 255);
+	sphere1CopperMat.Shininess = 12.8f;
+	sphere1CopperMat.Reflectivity = 1.0f;
+	sphere1CopperMat.Transparency = 0.0f;
+
+	Material sphere2SilverMat;
+	memset(&sphere2SilverMat, 0, sizeof(Material));
+	sphere2SilverMat.Ambient = sf::Color(49, 49, 49, 255);
+	sphere2SilverMat.Diffuse = sf::Color(129, 129, 129, 255);
+	sphere2SilverMat.Specular = sf::Color(130, 130, 130, 255);
+	sphere2SilverMat.Shininess = 51.2f;
+	sphere2SilverMat.Reflectivity = 0.3f;
+	sphere2SilverMat.Transparency = 0.5f;
+	sphere2SilverMat.RefractiveIndex = 1.55f;
+
+	Material greenRubberMat;
+	memset(&greenRubberMat, 0, sizeof(Material));
+	greenRubberMat.Ambient = sf::Color(0, 13, 0, 255);
+	greenRubberMat.Diffuse = sf::Color(102, 128, 102, 255);
+	greenRubberMat.Specular = sf::Color(10, 179, 10, 255);
+	greenRubberMat.Shininess = 10.0f;
+	greenRubberMat.Reflectivity = 0.4f;
+	greenRubberMat.Transparency = 0.0f;
+
+	Sphere* pSphere = new Sphere(sphere1CopperMat, 
+		glm::vec3(1.0f, 0.2f, 2.0f), 
+		0.2f,
+		"CopperSphere");
+	Sphere* pSphere2 = new Sphere(sphere2SilverMat,
+		glm::vec3(0.2f, 0.1f, 2.0f),
+		0.3f,
+		"SilverSphere");
+	Sphere* pSphere3 = new Sphere(greenRubberMat,
+		glm::vec3(2.0f, 0.5f, 4.0f), 
+		0.6f,
+		"SliverSphere2");
+	Plane* pPlaneBottom = new Plane(greenRubberMat,
+		Normal(0.0f, 1.0f, 0.0f), 
+		Point(0.0f, -3.0f, 0.0f),
+		"BottomPlane");
+
+	Box* pBox1 = new Box(sphere2SilverMat, 
+		glm::vec3(2.0f, 0.0f, 3.0f), 
+		1.0f, 
+		1.0f, 
+		1.0f, 
+		"FirstBox");
+
+	scene.AddObject(pSphere);
+	scene.AddObject(pSphere2);
+	scene.AddObject(pSphere3);
+	scene.AddObject(pPlaneBottom);
+	scene.AddObject(pBox1);
+}
+
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+
+bool AddMeshInstances(Scene& scene, const std::string& fileName, const glm::vec3& position, unsigned int uiInstanceCount)
+{
+	std::chrono::high_resolution_clock::time_point loadStart = std::chrono::high_resolution_clock::now();
+
+	MeshData meshData;
+	if (LoadMesh(fileName, meshData) == false)
+	{
+		return false;
+	}
+
+	Material meshMaterial;
+	memset(&meshMaterial, 0, sizeof(Material));
+	meshMaterial.Ambient = sf::Color(40, 40, 40, 255);
+	meshMaterial.Diffuse = sf::Color(180, 180, 180, 255);
+	meshMaterial.Specular = sf::Color(60, 60, 60, 255);
+	meshMaterial.Shininess = 20.0f;
+
+	std::shared_ptr<const MeshGeometry> pGeometry = std::make_shared<MeshGeometry>(std::move(meshData));
+
+	double dLoadSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - loadStart).count();
+	std::cout << "Loaded " << pGeometry->GetTriangleCount() << " triangles in " << dLoadSeconds * 1000.0 << " ms" << std::endl;
+
+	// The copies go along the x axis, each one turned a bit more around y
+	float fSpacing = glm::length(pGeometry->GetBounds().Extent()) * 1.1f;
+
+	for (unsigned int uiInstance = 0; uiInstance < uiInstanceCount; uiInstance++)
+	{
+		float fAngle = rad(30.0f * uiInstance);
+		glm::mat4x3 transform(glm::vec3(cosf(fAngle), 0.0f, -sinf(fAngle)),
+			glm::vec3(0.0f, 1.0f, 0.0f),
+			glm::vec3(sinf(fAngle), 0.0f, cosf(fAngle)),
+			position + glm::vec3(fSpacing * uiInstance, 0.0f, 0.0f));
+
+		scene.AddObject(new MeshInstance(meshMaterial, pGeometry, transform, "Mesh" + std::to_string(uiInstance)));
+	}
+
+	return true;
+}
\ No newline at end of file
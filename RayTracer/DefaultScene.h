@@ -0,0 +1,25 @@
+#ifndef __DEFAULTSCENE_H__
+#define __DEFAULTSCENE_H__
+
+#include <memory>
+#include <string>
+
+#include "Camera.h"
+#include "Scene.h"
+
+// ----------------------------------------------------------------------------
+
+// Fill the scene with the default set of lights and objects
+void CreateDefaultScene(Scene& scene);
+
+// Load an OBJ or binary PLY mesh and add uiInstanceCount copies of it in a
+// row from the position, all sharing its triangles. Returns false if the file
+// can't be loaded.
+bool AddMeshInstances(Scene& scene, const std::string& fileName, const glm::vec3& position, unsigned int uiInstanceCount);
+
+// Camera looking at the default scene for the given image size
+std::shared_ptr<Camera> CreateDefaultCamera(unsigned int uiWidth, unsigned int uiHeight);
+
+// ----------------------------------------------------------------------------
+
+#endif // __DEFAULTSCENE_H__
\ No newline at end of file
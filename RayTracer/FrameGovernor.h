@@ -0,0 +1,171 @@
+#ifndef __FRAMEGOVERNOR_H__
+#define __FRAMEGOVERNOR_H__
+
+#include "Common.h"
+
+// ----------------------------------------------------------------------------
+
+// Picks the render resolution and the area light samples of the real-time
+// frames so they take about the target time. The frames of a moving camera
+// go down a ladder of quality levels as soon as they are too slow, and back
+// up once the next level fits in the budget. A still camera gets the full
+// quality, and the level it had while moving when it starts again.
+class FrameGovernor
+{
+public:
+	struct QualityLevel
+	{
+		// Render size in eighths of the output size
+		unsigned int Scale;
+
+		// Area light samples per surface point, 0 for the full set
+		unsigned int AreaLightSamples;
+
+		// Estimated cost of a pixel relative to the full sample set
+		float PixelCost;
+	};
+
+	// Frames the camera has to stay still before the full quality is used
+	static const unsigned int STILL_FRAMES = 3;
+
+	// Frames the next level up has to fit before it is used
+	static const unsigned int RAISE_FRAMES = 5;
+
+	// A target frame rate of 0 leaves every frame at the full quality
+	FrameGovernor(float fTargetFrameRate, unsigned int uiOutputWidth, unsigned int uiOutputHeight)
+		: m_fTargetFrameTime(fTargetFrameRate > 0.0f ? 1.0f / fTargetFrameRate : 0.0f),
+		m_uiOutputWidth(uiOutputWidth),
+		m_uiOutputHeight(uiOutputHeight)
+	{ }
+
+	inline bool Enabled() const { return m_fTargetFrameTime > 0.0f; }
+
+	// Time of the last frame, at the current level. Returns true if the
+	// next frame has to be rendered at another level.
+	inline bool Update(float fFrameSeconds, bool bCameraMoving)
+	{
+		if (Enabled() == false)
+		{
+			return false;
+		}
+
+		unsigned int uiLevel = m_uiLevel;
+
+		m_uiStillFrames = bCameraMoving ? 0 : m_uiStillFrames + 1;
+
+		if (m_uiStillFrames >= STILL_FRAMES)
+		{
+			uiLevel = 0;
+		}
+		else if (m_uiLevel != m_uiMovingLevel)
+		{
+			// Started moving again, or just stopped
+			uiLevel = m_uiMovingLevel;
+		}
+		else if (m_uiSkipFrames > 0)
+		{
+			// The first frame of a level pays for the buffers and the
+			// history it lost
+			m_uiSkipFrames--;
+		}
+		else
+		{
+			m_fAverageFrameTime = (m_uiMeasuredFrames == 0) ? fFrameSeconds :
+				glm::mix(m_fAverageFrameTime, fFrameSeconds, 0.3f);
+			m_uiMeasuredFrames++;
+
+			if (m_fAverageFrameTime > m_fTargetFrameTime)
+			{
+				// Down to the first level expected to fit with some margin
+				while (uiLevel + 1 < LEVEL_COUNT &&
+					PredictedFrameTime(uiLevel) > m_fTargetFrameTime * 0.9f)
+				{
+					uiLevel++;
+				}
+				m_uiRaiseFrames = 0;
+			}
+			else if (uiLevel > 0 && PredictedFrameTime(uiLevel - 1) < m_fTargetFrameTime * 0.8f)
+			{
+				if (++m_uiRaiseFrames >= RAISE_FRAMES)
+				{
+					uiLevel--;
+				}
+			}
+			else
+			{
+				m_uiRaiseFrames = 0;
+			}
+
+			m_uiMovingLevel = uiLevel;
+		}
+
+		if (uiLevel == m_uiLevel)
+		{
+			return false;
+		}
+
+		m_uiLevel = uiLevel;
+		m_uiSkipFrames = 1;
+		m_uiMeasuredFrames = 0;
+		m_uiRaiseFrames = 0;
+		return true;
+	}
+
+	inline unsigned int GetRenderWidth() const { return glm::max(m_uiOutputWidth * GetLevel().Scale / 8, 1u); }
+	inline unsigned int GetRenderHeight() const { return glm::max(m_uiOutputHeight * GetLevel().Scale / 8, 1u); }
+	inline unsigned int GetAreaLightSampleLimit() const { return GetLevel().AreaLightSamples; }
+
+	inline const QualityLevel& GetLevel() const { return Levels()[m_uiLevel]; }
+
+private:
+	static const unsigned int LEVEL_COUNT = 10;
+
+	// From the best to the cheapest. The resolution goes down first, then
+	// the area light samples, which cost the most per pixel with soft shadows
+	// (the default lights take 16).
+	static inline const QualityLevel* Levels()
+	{
+		static const QualityLevel levels[LEVEL_COUNT] = {
+			{ 8, 0, 1.0f },
+			{ 7, 0, 1.0f },
+			{ 6, 0, 1.0f },
+			{ 5, 0, 1.0f },
+			{ 4, 0, 1.0f },
+			{ 4, 8, 0.6f },
+			{ 3, 8, 0.6f },
+			{ 3, 4, 0.4f },
+			{ 2, 4, 0.4f },
+			{ 2, 2, 0.3f },
+		};
+		return levels;
+	}
+
+	// The frame time scales with the pixel count and the cost of a pixel
+	inline float PredictedFrameTime(unsigned int uiLevel) const
+	{
+		const QualityLevel& current = GetLevel();
+		const QualityLevel& other = Levels()[uiLevel];
+
+		float fCurrentCost = (float)(current.Scale * current.Scale) * current.PixelCost;
+		float fOtherCost = (float)(other.Scale * other.Scale) * other.PixelCost;
+
+		return m_fAverageFrameTime * fOtherCost / fCurrentCost;
+	}
+
+	float m_fTargetFrameTime;
+	unsigned int m_uiOutputWidth;
+	unsigned int m_uiOutputHeight;
+
+	unsigned int m_uiLevel = 0;
+	unsigned int m_uiMovingLevel = 0;
+
+	float m_fAverageFrameTime = 0.0f;
+	unsigned int m_uiMeasuredFrames = 0;
+	unsigned int m_uiSkipFrames = 0;
+	unsigned int m_uiStillFrames = 0;
+	unsigned int m_uiRaiseFrames = 0;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __FRAMEGOVERNOR_H__
\ No newline at end of file
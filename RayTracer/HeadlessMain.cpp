@@ -0,0 +1,404 @@
+// -----------------------------------------------------------------------
+// Headless entry point. Renders the default scene without opening a
+// window or the UI, for batch nodes and benchmarking.
+//
+// RayTracerHeadless [options]
+//   --width N / --height N     Image size (default 1280x720)
+//   --frames N                 Number of frames to render (default 1)
+//   --threads N                Render workers, 0 = hardware threads
+//   --output FILE              Image written after the last frame
+//   --camera X Y Z PITCH YAW   Camera position and rotation
+//   --ssaa N                   Super sampling with up to N x N samples
+//   --no-adaptive              Take all of them in every pixel
+//   --seed N                   Seed for the soft shadow samples
+//   --low-discrepancy          Low discrepancy instead of stratified samples
+//   --progressive              Average one sample per pixel and frame
+//   --mesh FILE X Y Z          Add an OBJ or binary PLY mesh at the position
+//   --instances N              Copies of the mesh in a row, sharing its data
+//   --single-rays              Trace the primary rays one by one, no packets
+//   --wavefront                Trace the bounces a generation at a time
+//   --threshold X              Weight under which bounces are dropped
+//   --russian-roulette         Trace them with a probability instead
+//   --no-gbuffer               Trace the primary rays of every frame again
+//   --move NAME DX DY DZ       Move the objects named NAME* before every
+//                              frame after the first
+//   --no-dirty-tiles           Trace every tile of those frames
+//   --camera-step DX DY DZ DPITCH DYAW
+//                              Move and turn the camera before every frame
+//                              after the first
+//   --no-reprojection          Shade every pixel of those frames
+//   --target-fps X             Lower the resolution and area light samples
+//                              of the frames to render X per second, the
+//                              image is scaled up to the full size
+//   --shadows, --soft-shadows, --reflection, --refraction,
+//   --texturing, --phong       Render settings
+// -----------------------------------------------------------------------
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Common.h"
+#include "Camera.h"
+#include "Scene.h"
+#include "Renderer.h"
+#include "DefaultScene.h"
+#include "FrameGovernor.h"
+
+#include "SFML/Graphics/Image.hpp"
+
+// -----------------------------------------------------------------------
+
+struct HeadlessOptions
+{
+	unsigned int Width = 1280;
+	unsigned int Height = 720;
+	unsigned int FrameCount = 1;
+	unsigned int WorkerCount = 0;
+	std::string OutputFile = "raytraced.png";
+
+	bool CustomCamera = false;
+	glm::vec3 CameraPosition;
+	float CameraPitch = 0.0f;
+	float CameraYaw = 0.0f;
+
+	bool CameraMoving = false;
+	glm::vec3 CameraStep;
+	float CameraPitchStep = 0.0f;
+	float CameraYawStep = 0.0f;
+
+	float TargetFrameRate = 0.0f;
+
+	std::string MovedObjectName;
+	glm::vec3 MoveOffset;
+
+	std::string MeshFile;
+	glm::vec3 MeshPosition;
+	unsigned int MeshInstanceCount = 1;
+};
+
+// -----------------------------------------------------------------------
+
+void PrintUsage()
+{
+	std::cout << "Usage: RayTracerHeadless [--width N] [--height N] [--frames N] [--threads N]" << std::endl;
+	std::cout << "       [--output FILE] [--camera X Y Z PITCH YAW] [--ssaa N] [--no-adaptive] [--seed N]" << std::endl;
+	std::cout << "       [--low-discrepancy] [--progressive] [--mesh FILE X Y Z] [--instances N] [--single-rays] [--wavefront]" << std::endl;
+	std::cout << "       [--threshold X] [--russian-roulette] [--no-gbuffer] [--move NAME DX DY DZ] [--no-dirty-tiles]" << std::endl;
+	std::cout << "       [--camera-step DX DY DZ DPITCH DYAW] [--no-reprojection] [--target-fps X]" << std::endl;
+	std::cout << "       [--shadows] [--soft-shadows] [--reflection] [--refraction] [--texturing] [--phong]" << std::endl;
+}
+
+// -----------------------------------------------------------------------
+
+bool ParseOptions(int argc, char **argv, HeadlessOptions& options)
+{
+	for (int index = 1; index < argc; index++)
+	{
+		std::string argument = argv[index];
+
+		// Number of values following the current option
+		int iRemaining = argc - index - 1;
+
+		if (argument == "--width" && iRemaining >= 1)
+		{
+			options.Width = (unsigned int)atoi(argv[++index]);
+		}
+		else if (argument == "--height" && iRemaining >= 1)
+		{
+			options.Height = (unsigned int)atoi(argv[++index]);
+		}
+		else if (argument == "--frames" && iRemaining >= 1)
+		{
+			options.FrameCount = (unsigned int)atoi(argv[++index]);
+		}
+		else if (argument == "--threads" && iRemaining >= 1)
+		{
+			options.WorkerCount = (unsigned int)atoi(argv[++index]);
+		}
+		else if (argument == "--seed" && iRemaining >= 1)
+		{
+			RandomSeed = (unsigned int)atoi(argv[++index]);
+		}
+		else if (argument == "--low-discrepancy")
+		{
+			eSamplePattern = SamplePattern::keLOW_DISCREPANCY;
+		}
+		else if (argument == "--progressive")
+		{
+			ProgressiveEnabled = true;
+		}
+		else if (argument == "--mesh" && iRemaining >= 4)
+		{
+			options.MeshFile = argv[++index];
+			options.MeshPosition.x = (float)atof(argv[++index]);
+			options.MeshPosition.y = (float)atof(argv[++index]);
+			options.MeshPosition.z = (float)atof(argv[++index]);
+		}
+		else if (argument == "--instances" && iRemaining >= 1)
+		{
+			options.MeshInstanceCount = (unsigned int)atoi(argv[++index]);
+		}
+		else if (argument == "--single-rays")
+		{
+			PacketTracingEnabled = false;
+		}
+		else if (argument == "--wavefront")
+		{
+			WavefrontEnabled = true;
+		}
+		else if (argument == "--threshold" && iRemaining >= 1)
+		{
+			ContributionThreshold = (float)atof(argv[++index]);
+		}
+		else if (argument == "--russian-roulette")
+		{
+			RussianRouletteEnabled = true;
+		}
+		else if (argument == "--no-gbuffer")
+		{
+			GBufferEnabled = false;
+		}
+		else if (argument == "--move" && iRemaining >= 4)
+		{
+			options.MovedObjectName = argv[++index];
+			options.MoveOffset.x = (float)atof(argv[++index]);
+			options.MoveOffset.y = (float)atof(argv[++index]);
+			options.MoveOffset.z = (float)atof(argv[++index]);
+		}
+		else if (argument == "--no-dirty-tiles")
+		{
+			DirtyTilesEnabled = false;
+		}
+		else if (argument == "--camera-step" && iRemaining >= 5)
+		{
+			options.CameraMoving = true;
+			options.CameraStep.x = (float)atof(argv[++index]);
+			options.CameraStep.y = (float)atof(argv[++index]);
+			options.CameraStep.z = (float)atof(argv[++index]);
+			options.CameraPitchStep = (float)atof(argv[++index]);
+			options.CameraYawStep = (float)atof(argv[++index]);
+		}
+		else if (argument == "--no-reprojection")
+		{
+			ReprojectionEnabled = false;
+		}
+		else if (argument == "--target-fps" && iRemaining >= 1)
+		{
+			options.TargetFrameRate = (float)atof(argv[++index]);
+		}
+		else if (argument == "--output" && iRemaining >= 1)
+		{
+			options.OutputFile = argv[++index];
+		}
+		else if (argument == "--camera" && iRemaining >= 5)
+		{
+			options.CustomCamera = true;
+			options.CameraPosition.x = (float)atof(argv[++index]);
+			options.CameraPosition.y = (float)atof(argv[++index]);
+			options.CameraPosition.z = (float)atof(argv[++index]);
+			options.CameraPitch = (float)atof(argv[++index]);
+			options.CameraYaw = (float)atof(argv[++index]);
+		}
+		else if (argument == "--ssaa" && iRemaining >= 1)
+		{
+			SampleCount = atoi(argv[++index]);
+			SampleDistance = 1.0f / SampleCount;
+			SuperSamplingEnabled = true;
+		}
+		else if (argument == "--no-adaptive")
+		{
+			AdaptiveSuperSamplingEnabled = false;
+		}
+		else if (argument == "--shadows")
+		{
+			ShadowsEnabled = true;
+		}
+		else if (argument == "--soft-shadows")
+		{
+			SoftShadowsEnabled = true;
+		}
+		else if (argument == "--reflection")
+		{
+			ReflectionEnabled = true;
+		}
+		else if (argument == "--refraction")
+		{
+			RefractionEnabled = true;
+		}
+		else if (argument == "--texturing")
+		{
+			PlaneTexturingEnabled = true;
+		}
+		else if (argument == "--phong")
+		{
+			eLightModel = LightingModel::Phong;
+		}
+		else
+		{
+			std::cout << "Unknown or incomplete option: " << argument << std::endl;
+			return false;
+		}
+	}
+
+	if (options.Width == 0 || options.Height == 0 || options.FrameCount == 0 || SampleCount <= 0 ||
+		options.MeshInstanceCount == 0)
+	{
+		std::cout << "Image size, frame, sample and instance counts must be positive." << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+	// ------------------------------------------------------------------------
+
+	// Every frame is a full render unless progressive mode is asked for
+	ProgressiveEnabled = false;
+
+	HeadlessOptions options;
+	if (ParseOptions(argc, argv, options) == false)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// ------------------------------------------------------------------------
+
+	InitRenderer(options.Width, options.Height, options.WorkerCount);
+
+	pCam = CreateDefaultCamera(options.Width, options.Height);
+	if (options.CustomCamera)
+	{
+		pCam->SetPosition(options.CameraPosition);
+		pCam->SetXRotation(options.CameraPitch);
+		pCam->SetYRotation(options.CameraYaw);
+		pCam->UpdateViewMatrix();
+	}
+
+	CreateDefaultScene(scene);
+
+	if (options.MeshFile.empty() == false)
+	{
+		if (AddMeshInstances(scene, options.MeshFile, options.MeshPosition, options.MeshInstanceCount) == false)
+		{
+			ShutdownRenderer();
+			return 1;
+		}
+	}
+
+	// Every frame is traced, not only the ones after a UI change
+	Realtime = true;
+
+	// ------------------------------------------------------------------------
+	// Render
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double dTotalSeconds = 0.0;
+	double dFrameSeconds = 0.0;
+
+	FrameGovernor governor(options.TargetFrameRate, options.Width, options.Height);
+
+	for (unsigned int frame = 0; frame < options.FrameCount; frame++)
+	{
+		// Object names end with their index
+		if (frame > 0 && options.MovedObjectName.empty() == false)
+		{
+			for (Object* obj : scene.ObjectList())
+			{
+				if (obj->GetName().compare(0, options.MovedObjectName.size(), options.MovedObjectName) == 0)
+				{
+					obj->SetPosition(obj->GetPosition() + options.MoveOffset);
+					scene.MarkObjectMoved(obj);
+				}
+			}
+		}
+
+		// Only the camera steps count as moving, the full quality comes
+		// back after a few frames without them
+		if (frame > 0 && governor.Update((float)dFrameSeconds, options.CameraMoving) == true)
+		{
+			InitRenderer(governor.GetRenderWidth(), governor.GetRenderHeight(), options.WorkerCount);
+			AreaLightSampleLimit = governor.GetAreaLightSampleLimit();
+		}
+
+		if (frame > 0 && options.CameraMoving == true)
+		{
+			pCam->SetPosition(pCam->GetCameraPosition() + options.CameraStep);
+			pCam->SetXRotation(pCam->GetXRotation() + options.CameraPitchStep);
+			pCam->SetYRotation(pCam->GetYRotation() + options.CameraYawStep);
+			pCam->UpdateViewMatrix();
+		}
+
+		Clock::time_point frameStart = Clock::now();
+
+		RenderFrame();
+
+		dFrameSeconds = std::chrono::duration<double>(Clock::now() - frameStart).count();
+		dTotalSeconds += dFrameSeconds;
+
+		std::cout << "Frame " << frame << ": " << dFrameSeconds * 1000.0 << " ms, " << GetTracedTileCount() << " tiles";
+		if (GetReprojectedPixelCount() > 0)
+		{
+			std::cout << ", " << GetReprojectedPixelCount() << " pixels reprojected";
+		}
+		if (GetRefinedPixelCount() > 0)
+		{
+			std::cout << ", " << GetRefinedPixelCount() << " pixels refined";
+		}
+		if (governor.Enabled() == true)
+		{
+			std::cout << ", " << iWidth << "x" << iHeight;
+		}
+		std::cout << std::endl;
+	}
+
+	// Pixels of the output size, whatever the frames were rendered at
+	double dPixelCount = (double)options.Width * options.Height * options.FrameCount;
+
+	std::cout << "Average frame time: " << (dTotalSeconds / options.FrameCount) * 1000.0 << " ms" << std::endl;
+	std::cout << "Throughput: " << dPixelCount / dTotalSeconds / 1000000.0 << " Mpixels/s" << std::endl;
+
+	if (ProgressiveEnabled == true)
+	{
+		std::cout << "Samples per pixel: " << GetProgressiveSampleCount() << std::endl;
+	}
+
+	// ------------------------------------------------------------------------
+	// Save the last frame
+
+	std::vector<sf::Uint8> outputPixels(options.Width * options.Height * 4);
+	UpscaleFrame(outputPixels.data(), options.Width, options.Height);
+
+	sf::Image image;
+	image.create(options.Width, options.Height, outputPixels.data());
+
+	bool bSaved = image.saveToFile(options.OutputFile);
+	if (bSaved)
+	{
+		std::cout << "Image " << options.OutputFile << " exported" << std::endl;
+	}
+	else
+	{
+		std::cout << "Error writing " << options.OutputFile << std::endl;
+	}
+
+	// ------------------------------------------------------------------------
+
+	ShutdownRenderer();
+
+	// ------------------------------------------------------------------------
+
+	return bSaved ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------
\ No newline at end of file
@@ -0,0 +1,111 @@
+// -----------------------------------------------------------------------
+
+#include "ImageWriter.h"
+
+#include <iostream>
+
+#include "SFML/Graphics/Image.hpp"
+
+// -----------------------------------------------------------------------
+
+ImageWriter::ImageWriter()
+{
+	m_WriterThread = std::thread(&ImageWriter::WriterLoop, this);
+}
+
+// -----------------------------------------------------------------------
+
+ImageWriter::~ImageWriter()
+{
+	// Pending images are still written before the thread exits
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bShutdown = true;
+	}
+	m_JobAdded.notify_all();
+
+	m_WriterThread.join();
+}
+
+// -----------------------------------------------------------------------
+
+void ImageWriter::Save(const sf::Uint8* pPixels, unsigned int uiWidth, unsigned int uiHeight, const std::string& fileName)
+{
+	const sf::Uint8* pEnd = pPixels + uiWidth * uiHeight * 4;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		// Replace the snapshot of a pending write to the same file
+		for (WriteJob& job : m_vJobs)
+		{
+			if (job.FileName == fileName)
+			{
+				job.Pixels.assign(pPixels, pEnd);
+				job.Width = uiWidth;
+				job.Height = uiHeight;
+				return;
+			}
+		}
+
+		WriteJob job;
+		job.Pixels.assign(pPixels, pEnd);
+		job.Width = uiWidth;
+		job.Height = uiHeight;
+		job.FileName = fileName;
+
+		m_vJobs.push_back(std::move(job));
+	}
+
+	m_JobAdded.notify_one();
+}
+
+// -----------------------------------------------------------------------
+
+void ImageWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_JobsDone.wait(lock, [&]() { return m_vJobs.empty() && m_bWriting == false; });
+}
+
+// -----------------------------------------------------------------------
+
+void ImageWriter::WriterLoop()
+{
+	while (true)
+	{
+		WriteJob job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_JobAdded.wait(lock, [&]() { return m_bShutdown || m_vJobs.empty() == false; });
+
+			if (m_vJobs.empty())
+			{
+				// Shutdown requested and nothing left to write
+				return;
+			}
+
+			job = std::move(m_vJobs.front());
+			m_vJobs.pop_front();
+			m_bWriting = true;
+		}
+
+		// Encode and write outside of the lock
+		sf::Image image;
+		image.create(job.Width, job.Height, job.Pixels.data());
+
+		if (image.saveToFile(job.FileName) == false)
+		{
+			std::cout << "Error writing " << job.FileName << std::endl;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_bWriting = false;
+		}
+		m_JobsDone.notify_all();
+	}
+}
+
+// -----------------------------------------------------------------------
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef __IMAGEWRITER_H__
+#define __IMAGEWRITER_H__
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SFML/Config.hpp"
+
+// ----------------------------------------------------------------------------
+
+// Encodes and writes images on a background thread. Save copies the pixels
+// right away, so the caller can keep rendering into its buffer while the
+// encoding and the disk write happen on the writer thread.
+class ImageWriter
+{
+public:
+	ImageWriter();
+	~ImageWriter();
+
+	// Queue a snapshot of the RGBA pixels to be written to the file. A write
+	// still pending for the same file is replaced instead of queued again, so
+	// a slow disk can't make the queue grow without bound.
+	void Save(const sf::Uint8* pPixels, unsigned int uiWidth, unsigned int uiHeight, const std::string& fileName);
+
+	// Wait until all the queued images are written
+	void Flush();
+
+private:
+	struct WriteJob
+	{
+		std::vector<sf::Uint8> Pixels;
+		unsigned int Width;
+		unsigned int Height;
+		std::string FileName;
+	};
+
+	std::thread m_WriterThread;
+	std::deque<WriteJob> m_vJobs;
+	bool m_bWriting = false;
+	bool m_bShutdown = false;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_JobAdded;
+	std::condition_variable m_JobsDone;
+
+	void WriterLoop();
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __IMAGEWRITER_H__
\ No newline at end of file
@@ -99,6 +99,12 @@ public:
 		}
 	}
 
+	inline bool GetBoundingBox(AABB& bounds) override
+	{
+		bounds = AABB(Position - glm::vec3(RenderRadius), Position + glm::vec3(RenderRadius));
+		return true;
+	}
+
 protected:
 
 	float m_fSqRadius;
@@ -0,0 +1,157 @@
+// -----------------------------------------------------------------------
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+	: m_pData(nullptr), m_uiSize(0), m_hFile(INVALID_HANDLE_VALUE), m_hMapping(nullptr)
+{ }
+
+// -----------------------------------------------------------------------
+
+bool MappedFile::Open(const std::string& fileName)
+{
+	Close();
+
+	m_hFile = CreateFileA(fileName.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN,
+		nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(m_hFile, &fileSize) == FALSE || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_hMapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = (const char*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_pData == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	m_uiSize = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+void MappedFile::Close()
+{
+	if (m_pData != nullptr)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (m_hMapping != nullptr)
+	{
+		CloseHandle(m_hMapping);
+	}
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hFile);
+	}
+
+	m_pData = nullptr;
+	m_uiSize = 0;
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile()
+	: m_pData(nullptr), m_uiSize(0), m_iFile(-1)
+{ }
+
+// -----------------------------------------------------------------------
+
+bool MappedFile::Open(const std::string& fileName)
+{
+	Close();
+
+	m_iFile = open(fileName.c_str(), O_RDONLY);
+	if (m_iFile < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStatus;
+	if (fstat(m_iFile, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* pData = mmap(nullptr, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, m_iFile, 0);
+	if (pData == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	// The parsers read the file front to back
+	madvise(pData, (size_t)fileStatus.st_size, MADV_SEQUENTIAL);
+
+	m_pData = (const char*)pData;
+	m_uiSize = (size_t)fileStatus.st_size;
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+void MappedFile::Close()
+{
+	if (m_pData != nullptr)
+	{
+		munmap((void*)m_pData, m_uiSize);
+	}
+	if (m_iFile >= 0)
+	{
+		close(m_iFile);
+	}
+
+	m_pData = nullptr;
+	m_uiSize = 0;
+	m_iFile = -1;
+}
+
+#endif
+
+// -----------------------------------------------------------------------
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+// -----------------------------------------------------------------------
\ No newline at end of file
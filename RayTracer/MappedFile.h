@@ -0,0 +1,46 @@
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+#include <stddef.h>
+#include <string>
+
+// ----------------------------------------------------------------------------
+
+// Read-only memory mapping of a whole file. The pages are loaded by the OS on
+// first access, so parsers can walk the bytes in place without reading the
+// file into a buffer first.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Map the file, closing the one mapped before. Returns false if the file
+	// can't be opened or is empty.
+	bool Open(const std::string& fileName);
+	void Close();
+
+	inline bool IsOpen() const { return m_pData != nullptr; }
+
+	inline const char* Data() const { return m_pData; }
+	inline const char* End() const { return m_pData + m_uiSize; }
+	inline size_t Size() const { return m_uiSize; }
+
+private:
+	const char* m_pData;
+	size_t m_uiSize;
+
+#ifdef _WIN32
+	void* m_hFile;
+	void* m_hMapping;
+#else
+	int m_iFile;
+#endif
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __MAPPEDFILE_H__
\ No newline at end of file
@@ -0,0 +1,261 @@
+// -----------------------------------------------------------------------
+
+#include "Mesh.h"
+
+#include <limits>
+
+// -----------------------------------------------------------------------
+
+MeshGeometry::MeshGeometry(MeshData&& data)
+	: m_Data(std::move(data))
+{
+	unsigned int uiTriangleCount = m_Data.TriangleCount();
+
+	std::vector<AABB> triangleBounds(uiTriangleCount);
+	m_vTriangles.reserve(uiTriangleCount);
+
+	for (unsigned int uiTriangle = 0; uiTriangle < uiTriangleCount; uiTriangle++)
+	{
+		const uint32_t* pIndices = &m_Data.Indices[uiTriangle * 3];
+
+		glm::vec3 p1 = m_Data.GetPosition(pIndices[0]);
+		glm::vec3 p2 = m_Data.GetPosition(pIndices[1]);
+		glm::vec3 p3 = m_Data.GetPosition(pIndices[2]);
+
+		m_vTriangles.push_back(TriangleRecord(p1, p2, p3));
+
+		AABB& bounds = triangleBounds[uiTriangle];
+		bounds.Extend(p1);
+		bounds.Extend(p2);
+		bounds.Extend(p3);
+
+		m_Bounds.Extend(bounds);
+	}
+
+	m_BVH.Build(triangleBounds);
+}
+
+// -----------------------------------------------------------------------
+
+int MeshGeometry::Intersect(const glm::vec3& origin, const glm::vec3& direction, float& tMax, float& u, float& v) const
+{
+	int iClosestTriangle = -1;
+
+	auto intersectTriangle = [&](unsigned int uiTriangle, float& tMaxRay)
+	{
+		float t, fU, fV;
+		if (m_vTriangles[uiTriangle].Intersect(origin, direction, t, fU, fV) && t > 0.0f && t < tMaxRay)
+		{
+			tMaxRay = t;
+			iClosestTriangle = (int)uiTriangle;
+			u = fU;
+			v = fV;
+		}
+
+		return false;
+	};
+
+	// The direction is kept as it is, the ray's constructor would normalize it
+	Ray ray(origin);
+	ray.SetDirection(direction);
+
+	m_BVH.Traverse(ray, tMax, intersectTriangle);
+
+	return iClosestTriangle;
+}
+
+// -----------------------------------------------------------------------
+
+void MeshGeometry::IntersectPacket(const RayPacket& packet, float* tMax, int* triangles, float* u, float* v) const
+{
+	auto intersectTriangle = [&](unsigned int uiTriangle, unsigned int uiFirst, unsigned int uiLast)
+	{
+		for (unsigned int index = uiFirst; index <= uiLast; index++)
+		{
+			const Ray& ray = packet.Rays[index];
+
+			float t, fU, fV;
+			if (m_vTriangles[uiTriangle].Intersect(ray.GetOrigin(), ray.GetDirection(), t, fU, fV) && t > 0.0f && t < tMax[index])
+			{
+				tMax[index] = t;
+				triangles[index] = (int)uiTriangle;
+				u[index] = fU;
+				v[index] = fV;
+			}
+		}
+	};
+
+	m_BVH.TraversePacket(packet, tMax, intersectTriangle);
+}
+
+// -----------------------------------------------------------------------
+
+bool MeshGeometry::Occluded(const glm::vec3& origin, const glm::vec3& direction, float tMax) const
+{
+	bool bOccluded = false;
+
+	auto occludedByTriangle = [&](unsigned int uiTriangle, float& tMaxRay)
+	{
+		float t, u, v;
+		bOccluded = m_vTriangles[uiTriangle].Intersect(origin, direction, t, u, v) && t > 0.0f && t < tMaxRay;
+
+		// First blocker found => stop the traversal
+		return bOccluded;
+	};
+
+	Ray ray(origin);
+	ray.SetDirection(direction);
+
+	m_BVH.Traverse(ray, tMax, occludedByTriangle);
+
+	return bOccluded;
+}
+
+// -----------------------------------------------------------------------
+
+glm::vec3 MeshGeometry::GetNormal(unsigned int uiTriangle, float u, float v) const
+{
+	const uint32_t* pIndices = &m_Data.Indices[uiTriangle * 3];
+
+	glm::vec3 normal(0.0f);
+	if (m_Data.HasNormals())
+	{
+		normal = (1.0f - u - v) * m_Data.GetNormal(pIndices[0]) +
+			u * m_Data.GetNormal(pIndices[1]) +
+			v * m_Data.GetNormal(pIndices[2]);
+	}
+
+	// Face normal when there are no vertex normals or they cancel out
+	float fLength = glm::length(normal);
+	if (fLength > 0.0f)
+	{
+		return normal / fLength;
+	}
+
+	const TriangleRecord& triangle = m_vTriangles[uiTriangle];
+	return glm::normalize(glm::cross(triangle.E1, triangle.E2));
+}
+
+// -----------------------------------------------------------------------
+
+MeshInstance::MeshInstance(const Material& material,
+	std::shared_ptr<const MeshGeometry> geometry,
+	const glm::mat4x3& transform,
+	const std::string& name)
+	: Object(material, name), m_pGeometry(std::move(geometry)), m_Transform(transform)
+{
+	m_Type = ObjectType::keMESH;
+
+	UpdateInverse();
+}
+
+// -----------------------------------------------------------------------
+
+IntersectionInfo MeshInstance::FindIntersection(const Ray& ray)
+{
+	// Without normalizing the direction in mesh space, t is the same in both
+	// spaces
+	glm::vec3 origin = m_InverseTransform * glm::vec4(ray.GetOrigin(), 1.0f);
+	glm::vec3 direction = m_InverseTransform * glm::vec4(ray.GetDirection(), 0.0f);
+
+	float t = std::numeric_limits<float>::infinity();
+	float u, v;
+
+	int iTriangle = m_pGeometry->Intersect(origin, direction, t, u, v);
+	if (iTriangle < 0)
+	{
+		// Nothing was hit
+		return IntersectionInfo(vec3(0.0f), -1.0f, vec3(0.0f), NULL);
+	}
+
+	glm::vec3 normal = glm::normalize(m_NormalMatrix * m_pGeometry->GetNormal(iTriangle, u, v));
+
+	return IntersectionInfo(ray.GetOrigin() + t * ray.GetDirection(), t, normal, this);
+}
+
+// -----------------------------------------------------------------------
+
+void MeshInstance::IntersectPacket(const RayPacket& packet,
+	unsigned int uiFirst,
+	unsigned int uiLast,
+	float* tMax,
+	IntersectionInfo* results)
+{
+	// The transform keeps the origin shared, but may flip the direction signs.
+	// Ray index of the mesh packet is the packet's one minus uiFirst.
+	RayPacket meshPacket;
+	meshPacket.Reset(m_InverseTransform * glm::vec4(packet.Origin, 1.0f));
+
+	for (unsigned int index = uiFirst; index <= uiLast; index++)
+	{
+		Ray ray(meshPacket.Origin);
+		ray.SetDirection(m_InverseTransform * glm::vec4(packet.Rays[index].GetDirection(), 0.0f));
+		meshPacket.Add(ray);
+	}
+
+	meshPacket.Finalize();
+
+	if (meshPacket.Coherent == false)
+	{
+		Object::IntersectPacket(packet, uiFirst, uiLast, tMax, results);
+		return;
+	}
+
+	int triangles[RayPacket::MAX_SIZE];
+	float u[RayPacket::MAX_SIZE];
+	float v[RayPacket::MAX_SIZE];
+
+	for (unsigned int index = 0; index < meshPacket.Count; index++)
+	{
+		triangles[index] = -1;
+	}
+
+	m_pGeometry->IntersectPacket(meshPacket, tMax + uiFirst, triangles, u, v);
+
+	for (unsigned int index = 0; index < meshPacket.Count; index++)
+	{
+		if (triangles[index] >= 0)
+		{
+			unsigned int uiRay = uiFirst + index;
+			const Ray& ray = packet.Rays[uiRay];
+			glm::vec3 normal = glm::normalize(m_NormalMatrix * m_pGeometry->GetNormal(triangles[index], u[index], v[index]));
+
+			results[uiRay] = IntersectionInfo(ray.GetOrigin() + tMax[uiRay] * ray.GetDirection(), tMax[uiRay], normal, this);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------
+
+bool MeshInstance::Occluded(const Ray& ray, float tMax)
+{
+	glm::vec3 origin = m_InverseTransform * glm::vec4(ray.GetOrigin(), 1.0f);
+	glm::vec3 direction = m_InverseTransform * glm::vec4(ray.GetDirection(), 0.0f);
+
+	return m_pGeometry->Occluded(origin, direction, tMax);
+}
+
+// -----------------------------------------------------------------------
+
+bool MeshInstance::GetBoundingBox(AABB& bounds)
+{
+	const AABB& meshBounds = m_pGeometry->GetBounds();
+	if (meshBounds.IsValid() == false)
+	{
+		return false;
+	}
+
+	// Transformed center and the extent of the transformed half size along
+	// every world axis
+	glm::vec3 center = m_Transform * glm::vec4(meshBounds.Centroid(), 1.0f);
+	glm::vec3 halfSize = meshBounds.Extent() * 0.5f;
+
+	glm::mat3 linear(m_Transform);
+	glm::mat3 absLinear(glm::abs(linear[0]), glm::abs(linear[1]), glm::abs(linear[2]));
+	glm::vec3 extent = absLinear * halfSize;
+
+	bounds = AABB(center - extent, center + extent);
+	return true;
+}
+
+// -----------------------------------------------------------------------
\ No newline at end of file
@@ -0,0 +1,119 @@
+#ifndef __MESH_H__
+#define __MESH_H__
+
+#include <memory>
+
+#include "Common.h"
+#include "Object.h"
+#include "BVH.h"
+#include "MeshLoader.h"
+#include "Triangle.h"
+
+// ----------------------------------------------------------------------------
+
+// Triangles of a mesh and the bounding volume hierarchy over them, both in
+// the mesh's own space. The geometry never changes once built and is shared
+// by all the instances of the mesh. Both sides of the triangles are hit.
+// Every triangle also keeps its first vertex and edges for the ray tests,
+// which costs 36 bytes per triangle next to the indexed data.
+class MeshGeometry
+{
+public:
+	explicit MeshGeometry(MeshData&& data);
+
+	// Closest triangle hit in (0, tMax) by the ray origin + t * direction. The
+	// direction doesn't have to be unit length, t is measured in its units.
+	// Shrinks tMax to the hit distance and returns the triangle's index with
+	// the barycentric coordinates of the hit, or -1 if nothing is hit.
+	int Intersect(const glm::vec3& origin, const glm::vec3& direction, float& tMax, float& u, float& v) const;
+
+	// Closest hits of a coherent packet given in mesh space. Rays hitting a
+	// triangle before their entry of tMax get it shrunk and the triangle and
+	// barycentric coordinates stored in their entries of the other arrays.
+	void IntersectPacket(const RayPacket& packet, float* tMax, int* triangles, float* u, float* v) const;
+
+	// Any triangle hit in (0, tMax)
+	bool Occluded(const glm::vec3& origin, const glm::vec3& direction, float tMax) const;
+
+	// Unit normal at a hit, interpolated from the vertex normals when the mesh
+	// has some and following the winding order of the file otherwise
+	glm::vec3 GetNormal(unsigned int uiTriangle, float u, float v) const;
+
+	inline const AABB& GetBounds() const { return m_Bounds; }
+	inline const MeshData& GetData() const { return m_Data; }
+	inline unsigned int GetTriangleCount() const { return m_Data.TriangleCount(); }
+
+private:
+	MeshData m_Data;
+	BVH m_BVH;
+	AABB m_Bounds;
+
+	// By triangle index
+	std::vector<TriangleRecord> m_vTriangles;
+};
+
+// ----------------------------------------------------------------------------
+
+// Copy of a mesh placed in the scene with its own material and 3x4 transform.
+// The scene's hierarchy is the top level over the instances; a ray reaching
+// an instance is moved into the mesh's space and continues in the shared
+// bottom level hierarchy. Moving an instance only changes its world bounds,
+// so the scene refits its own hierarchy and the mesh's is left untouched.
+class MeshInstance : public Object
+{
+public:
+	MeshInstance(const Material& material,
+		std::shared_ptr<const MeshGeometry> geometry,
+		const glm::mat4x3& transform,
+		const std::string& name);
+
+	IntersectionInfo FindIntersection(const Ray& ray);
+	bool Occluded(const Ray& ray, float tMax);
+
+	void IntersectPacket(const RayPacket& packet,
+		unsigned int uiFirst,
+		unsigned int uiLast,
+		float* tMax,
+		IntersectionInfo* results);
+
+	bool GetBoundingBox(AABB& bounds) override;
+
+	// Translation of the transform
+	inline glm::vec3 GetPosition() override { return m_Transform[3]; }
+	inline void SetPosition(const glm::vec3& newPosition)
+	{
+		m_Transform[3] = newPosition;
+		UpdateInverse();
+	}
+
+	// Mesh space to world space, the last column is the translation
+	inline const glm::mat4x3& GetTransform() const { return m_Transform; }
+	inline void SetTransform(const glm::mat4x3& transform)
+	{
+		m_Transform = transform;
+		UpdateInverse();
+	}
+
+	inline const std::shared_ptr<const MeshGeometry>& GetGeometry() const { return m_pGeometry; }
+
+private:
+	std::shared_ptr<const MeshGeometry> m_pGeometry;
+
+	glm::mat4x3 m_Transform;
+	glm::mat4x3 m_InverseTransform;
+
+	// Inverse transpose of the linear part, brings the normals to world space
+	glm::mat3 m_NormalMatrix;
+
+	inline void UpdateInverse()
+	{
+		glm::mat3 inverseLinear = glm::inverse(glm::mat3(m_Transform));
+
+		m_InverseTransform = glm::mat4x3(inverseLinear[0], inverseLinear[1], inverseLinear[2], -(inverseLinear * m_Transform[3]));
+		m_NormalMatrix = glm::transpose(inverseLinear);
+	}
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __MESH_H__
\ No newline at end of file
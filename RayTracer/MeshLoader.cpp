@@ -0,0 +1,784 @@
+// -----------------------------------------------------------------------
+
+#include "MeshLoader.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include <string.h>
+
+#include "MappedFile.h"
+
+// -----------------------------------------------------------------------
+
+namespace
+{
+	const uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+	// -------------------------------------------------------------------
+	// Text parsing. The mapped file isn't null terminated, so every
+	// function takes the end of the data and never reads past it.
+
+	inline bool IsBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	inline const char* SkipBlanks(const char* p, const char* pEnd)
+	{
+		while (p < pEnd && IsBlank(*p))
+		{
+			p++;
+		}
+		return p;
+	}
+
+	// First character of the next line
+	inline const char* NextLine(const char* p, const char* pEnd)
+	{
+		const char* pNewLine = (const char*)memchr(p, '\n', pEnd - p);
+		return (pNewLine != nullptr) ? pNewLine + 1 : pEnd;
+	}
+
+	// Returns the first character after the number, or nullptr if p doesn't
+	// start with a number
+	const char* ParseFloat(const char* p, const char* pEnd, float& fValue)
+	{
+		static const double powersOfTen[] =
+		{
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+			1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		bool bNegative = false;
+		if (p < pEnd && (*p == '-' || *p == '+'))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+
+		// Up to 19 significant digits fit in the mantissa, the others only
+		// move the decimal point
+		uint64_t ullMantissa = 0;
+		int iDigitCount = 0;
+		int iExponent = 0;
+		bool bHasDigits = false;
+
+		for (; p < pEnd && IsDigit(*p); p++)
+		{
+			bHasDigits = true;
+			if (iDigitCount < 19)
+			{
+				ullMantissa = ullMantissa * 10 + (*p - '0');
+				iDigitCount += (ullMantissa != 0) ? 1 : 0;
+			}
+			else
+			{
+				iExponent++;
+			}
+		}
+
+		if (p < pEnd && *p == '.')
+		{
+			for (p++; p < pEnd && IsDigit(*p); p++)
+			{
+				bHasDigits = true;
+				if (iDigitCount < 19)
+				{
+					ullMantissa = ullMantissa * 10 + (*p - '0');
+					iDigitCount += (ullMantissa != 0) ? 1 : 0;
+					iExponent--;
+				}
+			}
+		}
+
+		if (bHasDigits == false)
+		{
+			return nullptr;
+		}
+
+		if (p < pEnd && (*p == 'e' || *p == 'E'))
+		{
+			const char* pExponent = p + 1;
+
+			bool bNegativeExponent = false;
+			if (pExponent < pEnd && (*pExponent == '-' || *pExponent == '+'))
+			{
+				bNegativeExponent = (*pExponent == '-');
+				pExponent++;
+			}
+
+			if (pExponent < pEnd && IsDigit(*pExponent))
+			{
+				int iValue = 0;
+				for (; pExponent < pEnd && IsDigit(*pExponent); pExponent++)
+				{
+					iValue = (iValue < 10000) ? iValue * 10 + (*pExponent - '0') : iValue;
+				}
+
+				iExponent += bNegativeExponent ? -iValue : iValue;
+				p = pExponent;
+			}
+		}
+
+		double dValue = (double)ullMantissa;
+		while (iExponent > 22) { dValue *= 1e22; iExponent -= 22; }
+		while (iExponent < -22) { dValue /= 1e22; iExponent += 22; }
+		dValue = (iExponent >= 0) ? dValue * powersOfTen[iExponent] : dValue / powersOfTen[-iExponent];
+
+		fValue = (float)(bNegative ? -dValue : dValue);
+		return p;
+	}
+
+	const char* ParseInteger(const char* p, const char* pEnd, long long& llValue)
+	{
+		bool bNegative = false;
+		if (p < pEnd && (*p == '-' || *p == '+'))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+
+		if (p >= pEnd || IsDigit(*p) == false)
+		{
+			return nullptr;
+		}
+
+		long long llResult = 0;
+		for (; p < pEnd && IsDigit(*p); p++)
+		{
+			llResult = llResult * 10 + (*p - '0');
+		}
+
+		llValue = bNegative ? -llResult : llResult;
+		return p;
+	}
+
+	// -------------------------------------------------------------------
+	// OBJ
+
+	// OBJ indices start at 1, negative ones count back from the last element
+	inline uint32_t ResolveOBJIndex(long long llIndex, size_t uiCount)
+	{
+		if (llIndex > 0)
+		{
+			return (uint32_t)(llIndex - 1);
+		}
+		if (llIndex < 0 && (size_t)(-llIndex) <= uiCount)
+		{
+			return (uint32_t)(uiCount + llIndex);
+		}
+		return INVALID_INDEX;
+	}
+
+	// -------------------------------------------------------------------
+	// PLY
+
+	enum PLYType
+	{
+		kePLY_INT8,
+		kePLY_UINT8,
+		kePLY_INT16,
+		kePLY_UINT16,
+		kePLY_INT32,
+		kePLY_UINT32,
+		kePLY_FLOAT32,
+		kePLY_FLOAT64,
+		kePLY_INVALID,
+	};
+
+	struct PLYProperty
+	{
+		std::string Name;
+		PLYType Type = kePLY_INVALID;
+
+		// Lists store a count of CountType followed by the values of Type
+		bool IsList = false;
+		PLYType CountType = kePLY_INVALID;
+	};
+
+	struct PLYElement
+	{
+		std::string Name;
+		size_t Count = 0;
+		std::vector<PLYProperty> Properties;
+	};
+
+	PLYType ParsePLYType(const std::string& name)
+	{
+		if (name == "char" || name == "int8") return kePLY_INT8;
+		if (name == "uchar" || name == "uint8") return kePLY_UINT8;
+		if (name == "short" || name == "int16") return kePLY_INT16;
+		if (name == "ushort" || name == "uint16") return kePLY_UINT16;
+		if (name == "int" || name == "int32") return kePLY_INT32;
+		if (name == "uint" || name == "uint32") return kePLY_UINT32;
+		if (name == "float" || name == "float32") return kePLY_FLOAT32;
+		if (name == "double" || name == "float64") return kePLY_FLOAT64;
+		return kePLY_INVALID;
+	}
+
+	inline size_t PLYTypeSize(PLYType type)
+	{
+		static const size_t sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+		return sizes[type];
+	}
+
+	// Read one value in place. The bytes are copied into a local of the right
+	// type since the records aren't aligned.
+	inline double ReadPLYValue(const char* p, PLYType type, bool bSwapBytes)
+	{
+		char bytes[8];
+		size_t uiSize = PLYTypeSize(type);
+		for (size_t index = 0; index < uiSize; index++)
+		{
+			bytes[index] = bSwapBytes ? p[uiSize - 1 - index] : p[index];
+		}
+
+		switch (type)
+		{
+			case kePLY_INT8: { int8_t value; memcpy(&value, bytes, 1); return value; }
+			case kePLY_UINT8: { uint8_t value; memcpy(&value, bytes, 1); return value; }
+			case kePLY_INT16: { int16_t value; memcpy(&value, bytes, 2); return value; }
+			case kePLY_UINT16: { uint16_t value; memcpy(&value, bytes, 2); return value; }
+			case kePLY_INT32: { int32_t value; memcpy(&value, bytes, 4); return value; }
+			case kePLY_UINT32: { uint32_t value; memcpy(&value, bytes, 4); return value; }
+			case kePLY_FLOAT32: { float value; memcpy(&value, bytes, 4); return value; }
+			case kePLY_FLOAT64: { double value; memcpy(&value, bytes, 8); return value; }
+			default: return 0.0;
+		}
+	}
+
+	inline bool IsLittleEndianHost()
+	{
+		const uint16_t usValue = 1;
+		char firstByte;
+		memcpy(&firstByte, &usValue, 1);
+		return firstByte == 1;
+	}
+
+	// Next whitespace separated word of the header line [p, pLineEnd)
+	inline std::string NextWord(const char*& p, const char* pLineEnd)
+	{
+		p = SkipBlanks(p, pLineEnd);
+
+		const char* pStart = p;
+		while (p < pLineEnd && IsBlank(*p) == false && *p != '\n')
+		{
+			p++;
+		}
+
+		return std::string(pStart, p);
+	}
+}
+
+// -----------------------------------------------------------------------
+
+bool LoadMesh(const std::string& fileName, MeshData& mesh)
+{
+	size_t uiDot = fileName.find_last_of('.');
+	std::string extension = (uiDot != std::string::npos) ? fileName.substr(uiDot + 1) : std::string();
+
+	for (char& c : extension)
+	{
+		c = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+	}
+
+	if (extension == "obj")
+	{
+		return LoadOBJ(fileName, mesh);
+	}
+	if (extension == "ply")
+	{
+		return LoadPLY(fileName, mesh);
+	}
+
+	std::cout << "Unknown mesh format: " << fileName << std::endl;
+	mesh.Clear();
+	return false;
+}
+
+// -----------------------------------------------------------------------
+
+bool LoadOBJ(const std::string& fileName, MeshData& mesh)
+{
+	mesh.Clear();
+
+	MappedFile file;
+	if (file.Open(fileName) == false)
+	{
+		std::cout << "Error opening " << fileName << std::endl;
+		return false;
+	}
+
+	const char* p = file.Data();
+	const char* pEnd = file.End();
+
+	// Rough guess of the element counts from the file size, a vertex line
+	// takes about 30 bytes and every vertex is used by about two triangles
+	size_t uiVertexGuess = file.Size() / 90;
+	mesh.PositionX.reserve(uiVertexGuess);
+	mesh.PositionY.reserve(uiVertexGuess);
+	mesh.PositionZ.reserve(uiVertexGuess);
+	mesh.Indices.reserve(uiVertexGuess * 6);
+
+	// Normals of the file and the normal used by every face corner, resolved
+	// to per vertex normals once all the positions are known
+	std::vector<float> normalX, normalY, normalZ;
+	std::vector<uint32_t> cornerNormals;
+
+	// Corners of the current face
+	std::vector<uint32_t> facePositions;
+	std::vector<uint32_t> faceNormals;
+
+	unsigned int uiLine = 0;
+
+	auto fail = [&](const char* pMessage)
+	{
+		std::cout << fileName << "(" << uiLine << "): " << pMessage << std::endl;
+		mesh.Clear();
+		return false;
+	};
+
+	while (p < pEnd)
+	{
+		uiLine++;
+
+		p = SkipBlanks(p, pEnd);
+		const char* pLineEnd = NextLine(p, pEnd);
+
+		if (pLineEnd - p >= 2 && p[0] == 'v' && IsBlank(p[1]))
+		{
+			float x, y, z;
+			const char* pValue = SkipBlanks(p + 2, pLineEnd);
+			if ((pValue = ParseFloat(pValue, pLineEnd, x)) == nullptr ||
+				(pValue = ParseFloat(SkipBlanks(pValue, pLineEnd), pLineEnd, y)) == nullptr ||
+				(pValue = ParseFloat(SkipBlanks(pValue, pLineEnd), pLineEnd, z)) == nullptr)
+			{
+				return fail("invalid vertex");
+			}
+
+			mesh.PositionX.push_back(x);
+			mesh.PositionY.push_back(y);
+			mesh.PositionZ.push_back(z);
+		}
+		else if (pLineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && IsBlank(p[2]))
+		{
+			float x, y, z;
+			const char* pValue = SkipBlanks(p + 3, pLineEnd);
+			if ((pValue = ParseFloat(pValue, pLineEnd, x)) == nullptr ||
+				(pValue = ParseFloat(SkipBlanks(pValue, pLineEnd), pLineEnd, y)) == nullptr ||
+				(pValue = ParseFloat(SkipBlanks(pValue, pLineEnd), pLineEnd, z)) == nullptr)
+			{
+				return fail("invalid normal");
+			}
+
+			normalX.push_back(x);
+			normalY.push_back(y);
+			normalZ.push_back(z);
+		}
+		else if (pLineEnd - p >= 2 && p[0] == 'f' && IsBlank(p[1]))
+		{
+			facePositions.clear();
+			faceNormals.clear();
+
+			// Corners are v, v/vt, v//vn or v/vt/vn
+			const char* pCorner = SkipBlanks(p + 2, pLineEnd);
+			while (pCorner < pLineEnd && *pCorner != '\n')
+			{
+				long long llPosition, llUnused, llNormal = 0;
+
+				pCorner = ParseInteger(pCorner, pLineEnd, llPosition);
+				if (pCorner == nullptr)
+				{
+					return fail("invalid face");
+				}
+
+				if (pCorner < pLineEnd && *pCorner == '/')
+				{
+					pCorner++;
+					if (pCorner < pLineEnd && *pCorner != '/')
+					{
+						pCorner = ParseInteger(pCorner, pLineEnd, llUnused);
+						if (pCorner == nullptr)
+						{
+							return fail("invalid face");
+						}
+					}
+					if (pCorner < pLineEnd && *pCorner == '/')
+					{
+						pCorner = ParseInteger(pCorner + 1, pLineEnd, llNormal);
+						if (pCorner == nullptr)
+						{
+							return fail("invalid face");
+						}
+					}
+				}
+
+				uint32_t uiPosition = ResolveOBJIndex(llPosition, mesh.PositionX.size());
+				uint32_t uiNormal = (llNormal != 0) ? ResolveOBJIndex(llNormal, normalX.size()) : INVALID_INDEX;
+				if (uiPosition == INVALID_INDEX || (llNormal != 0 && uiNormal == INVALID_INDEX))
+				{
+					return fail("face index out of range");
+				}
+
+				facePositions.push_back(uiPosition);
+				faceNormals.push_back(uiNormal);
+
+				pCorner = SkipBlanks(pCorner, pLineEnd);
+			}
+
+			if (facePositions.size() < 3)
+			{
+				return fail("face with less than three corners");
+			}
+
+			// Triangle fan around the first corner
+			for (size_t index = 2; index < facePositions.size(); index++)
+			{
+				mesh.Indices.push_back(facePositions[0]);
+				mesh.Indices.push_back(facePositions[index - 1]);
+				mesh.Indices.push_back(facePositions[index]);
+
+				cornerNormals.push_back(faceNormals[0]);
+				cornerNormals.push_back(faceNormals[index - 1]);
+				cornerNormals.push_back(faceNormals[index]);
+			}
+		}
+
+		// Texture coordinates, groups, materials and comments are ignored
+		p = pLineEnd;
+	}
+
+	for (uint32_t uiIndex : mesh.Indices)
+	{
+		if (uiIndex >= mesh.VertexCount())
+		{
+			return fail("face index out of range");
+		}
+	}
+
+	if (normalX.empty() == false)
+	{
+		// Vertices no face gives a normal keep a zero one, the mesh falls
+		// back to the face normal for them
+		mesh.NormalX.assign(mesh.VertexCount(), 0.0f);
+		mesh.NormalY.assign(mesh.VertexCount(), 0.0f);
+		mesh.NormalZ.assign(mesh.VertexCount(), 0.0f);
+
+		for (size_t index = 0; index < cornerNormals.size(); index++)
+		{
+			uint32_t uiNormal = cornerNormals[index];
+			if (uiNormal != INVALID_INDEX)
+			{
+				uint32_t uiVertex = mesh.Indices[index];
+				mesh.NormalX[uiVertex] = normalX[uiNormal];
+				mesh.NormalY[uiVertex] = normalY[uiNormal];
+				mesh.NormalZ[uiVertex] = normalZ[uiNormal];
+			}
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool LoadPLY(const std::string& fileName, MeshData& mesh)
+{
+	mesh.Clear();
+
+	MappedFile file;
+	if (file.Open(fileName) == false)
+	{
+		std::cout << "Error opening " << fileName << std::endl;
+		return false;
+	}
+
+	const char* p = file.Data();
+	const char* pEnd = file.End();
+
+	auto fail = [&](const char* pMessage)
+	{
+		std::cout << fileName << ": " << pMessage << std::endl;
+		mesh.Clear();
+		return false;
+	};
+
+	// --------------------------------------------------------------------
+	// Header
+
+	if (pEnd - p < 4 || memcmp(p, "ply", 3) != 0)
+	{
+		return fail("not a PLY file");
+	}
+
+	bool bBigEndian = false;
+	bool bHeaderEnded = false;
+	std::vector<PLYElement> elements;
+
+	for (p = NextLine(p, pEnd); p < pEnd && bHeaderEnded == false; )
+	{
+		const char* pLineEnd = NextLine(p, pEnd);
+		std::string keyword = NextWord(p, pLineEnd);
+
+		if (keyword == "format")
+		{
+			std::string format = NextWord(p, pLineEnd);
+			if (format == "binary_little_endian")
+			{
+				bBigEndian = false;
+			}
+			else if (format == "binary_big_endian")
+			{
+				bBigEndian = true;
+			}
+			else
+			{
+				return fail("only binary PLY files are supported");
+			}
+		}
+		else if (keyword == "element")
+		{
+			PLYElement element;
+			element.Name = NextWord(p, pLineEnd);
+
+			long long llCount;
+			std::string count = NextWord(p, pLineEnd);
+			if (ParseInteger(count.data(), count.data() + count.size(), llCount) == nullptr || llCount < 0)
+			{
+				return fail("invalid element count");
+			}
+
+			element.Count = (size_t)llCount;
+			elements.push_back(element);
+		}
+		else if (keyword == "property")
+		{
+			if (elements.empty())
+			{
+				return fail("property outside of an element");
+			}
+
+			PLYProperty property;
+
+			std::string type = NextWord(p, pLineEnd);
+			if (type == "list")
+			{
+				property.IsList = true;
+				property.CountType = ParsePLYType(NextWord(p, pLineEnd));
+				type = NextWord(p, pLineEnd);
+			}
+
+			property.Type = ParsePLYType(type);
+			property.Name = NextWord(p, pLineEnd);
+
+			if (property.Type == kePLY_INVALID ||
+				(property.IsList && (property.CountType == kePLY_INVALID || property.CountType == kePLY_FLOAT32 || property.CountType == kePLY_FLOAT64)))
+			{
+				return fail("invalid property type");
+			}
+
+			elements.back().Properties.push_back(property);
+		}
+		else if (keyword == "end_header")
+		{
+			bHeaderEnded = true;
+		}
+
+		// Comments and obj_info lines are ignored
+		p = pLineEnd;
+	}
+
+	if (bHeaderEnded == false)
+	{
+		return fail("missing end_header");
+	}
+
+	const bool bSwapBytes = (bBigEndian == IsLittleEndianHost());
+
+	// --------------------------------------------------------------------
+	// Body, the elements follow each other in header order
+
+	for (const PLYElement& element : elements)
+	{
+		const bool bVertex = (element.Name == "vertex");
+		const bool bFace = (element.Name == "face");
+
+		// Offset of the vertex attributes in a record, -1 if absent
+		int positionProperty[3] = { -1, -1, -1 };
+		int normalProperty[3] = { -1, -1, -1 };
+		int iIndexProperty = -1;
+
+		bool bFixedSize = true;
+		size_t uiRecordSize = 0;
+
+		for (size_t index = 0; index < element.Properties.size(); index++)
+		{
+			const PLYProperty& property = element.Properties[index];
+
+			if (bVertex && property.IsList == false)
+			{
+				static const char* positionNames[3] = { "x", "y", "z" };
+				static const char* normalNames[3] = { "nx", "ny", "nz" };
+
+				for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+				{
+					if (property.Name == positionNames[uiAxis]) positionProperty[uiAxis] = (int)index;
+					if (property.Name == normalNames[uiAxis]) normalProperty[uiAxis] = (int)index;
+				}
+			}
+
+			if (bFace && property.IsList && (property.Name == "vertex_indices" || property.Name == "vertex_index"))
+			{
+				iIndexProperty = (int)index;
+			}
+
+			bFixedSize = bFixedSize && (property.IsList == false);
+			uiRecordSize += PLYTypeSize(property.Type);
+		}
+
+		if (bVertex)
+		{
+			if (bFixedSize == false || positionProperty[0] < 0 || positionProperty[1] < 0 || positionProperty[2] < 0)
+			{
+				return fail("vertices need fixed size x, y and z properties");
+			}
+
+			if ((size_t)(pEnd - p) / uiRecordSize < element.Count)
+			{
+				return fail("file truncated in the vertex data");
+			}
+
+			// Byte offset of every property in the record
+			std::vector<size_t> offsets;
+			size_t uiOffset = 0;
+			for (const PLYProperty& property : element.Properties)
+			{
+				offsets.push_back(uiOffset);
+				uiOffset += PLYTypeSize(property.Type);
+			}
+
+			const bool bNormals = normalProperty[0] >= 0 && normalProperty[1] >= 0 && normalProperty[2] >= 0;
+
+			mesh.PositionX.resize(element.Count);
+			mesh.PositionY.resize(element.Count);
+			mesh.PositionZ.resize(element.Count);
+			if (bNormals)
+			{
+				mesh.NormalX.resize(element.Count);
+				mesh.NormalY.resize(element.Count);
+				mesh.NormalZ.resize(element.Count);
+			}
+
+			float* positions[3] = { mesh.PositionX.data(), mesh.PositionY.data(), mesh.PositionZ.data() };
+			float* normals[3] = { mesh.NormalX.data(), mesh.NormalY.data(), mesh.NormalZ.data() };
+
+			for (size_t uiVertex = 0; uiVertex < element.Count; uiVertex++, p += uiRecordSize)
+			{
+				for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+				{
+					const PLYProperty& position = element.Properties[positionProperty[uiAxis]];
+					positions[uiAxis][uiVertex] = (float)ReadPLYValue(p + offsets[positionProperty[uiAxis]], position.Type, bSwapBytes);
+
+					if (bNormals)
+					{
+						const PLYProperty& normal = element.Properties[normalProperty[uiAxis]];
+						normals[uiAxis][uiVertex] = (float)ReadPLYValue(p + offsets[normalProperty[uiAxis]], normal.Type, bSwapBytes);
+					}
+				}
+			}
+		}
+		else if (bFixedSize)
+		{
+			// Nothing needed from this element, skip it at once
+			if ((size_t)(pEnd - p) / std::max(uiRecordSize, (size_t)1) < element.Count)
+			{
+				return fail("file truncated");
+			}
+
+			p += uiRecordSize * element.Count;
+		}
+		else
+		{
+			if (bFace)
+			{
+				if (iIndexProperty < 0)
+				{
+					return fail("faces need a vertex_indices list");
+				}
+
+				mesh.Indices.reserve(element.Count * 3);
+			}
+
+			for (size_t uiRecord = 0; uiRecord < element.Count; uiRecord++)
+			{
+				for (size_t index = 0; index < element.Properties.size(); index++)
+				{
+					const PLYProperty& property = element.Properties[index];
+
+					size_t uiValueCount = 1;
+					if (property.IsList)
+					{
+						if ((size_t)(pEnd - p) < PLYTypeSize(property.CountType))
+						{
+							return fail("file truncated");
+						}
+
+						double dCount = ReadPLYValue(p, property.CountType, bSwapBytes);
+						if (dCount < 0.0)
+						{
+							return fail("negative list size");
+						}
+
+						uiValueCount = (size_t)dCount;
+						p += PLYTypeSize(property.CountType);
+					}
+
+					size_t uiValueSize = PLYTypeSize(property.Type);
+					if ((size_t)(pEnd - p) / uiValueSize < uiValueCount)
+					{
+						return fail("file truncated");
+					}
+
+					if ((int)index == iIndexProperty && uiValueCount >= 3)
+					{
+						// Triangle fan around the first corner
+						uint32_t uiFirst = (uint32_t)ReadPLYValue(p, property.Type, bSwapBytes);
+						uint32_t uiPrevious = (uint32_t)ReadPLYValue(p + uiValueSize, property.Type, bSwapBytes);
+
+						for (size_t uiCorner = 2; uiCorner < uiValueCount; uiCorner++)
+						{
+							uint32_t uiCurrent = (uint32_t)ReadPLYValue(p + uiCorner * uiValueSize, property.Type, bSwapBytes);
+
+							mesh.Indices.push_back(uiFirst);
+							mesh.Indices.push_back(uiPrevious);
+							mesh.Indices.push_back(uiCurrent);
+
+							uiPrevious = uiCurrent;
+						}
+					}
+
+					p += uiValueCount * uiValueSize;
+				}
+			}
+		}
+	}
+
+	for (uint32_t uiIndex : mesh.Indices)
+	{
+		if (uiIndex >= mesh.VertexCount())
+		{
+			return fail("face index out of range");
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef __MESHLOADER_H__
+#define __MESHLOADER_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Common.h"
+
+// ----------------------------------------------------------------------------
+
+// Indexed triangle list with the vertex attributes stored as one array per
+// component. The normals are either empty or hold one normal per vertex.
+struct MeshData
+{
+	std::vector<float> PositionX;
+	std::vector<float> PositionY;
+	std::vector<float> PositionZ;
+
+	std::vector<float> NormalX;
+	std::vector<float> NormalY;
+	std::vector<float> NormalZ;
+
+	// Three vertex indices per triangle
+	std::vector<uint32_t> Indices;
+
+	inline unsigned int VertexCount() const { return (unsigned int)PositionX.size(); }
+	inline unsigned int TriangleCount() const { return (unsigned int)Indices.size() / 3; }
+	inline bool HasNormals() const { return NormalX.empty() == false; }
+
+	inline glm::vec3 GetPosition(uint32_t uiVertex) const
+	{
+		return glm::vec3(PositionX[uiVertex], PositionY[uiVertex], PositionZ[uiVertex]);
+	}
+
+	inline glm::vec3 GetNormal(uint32_t uiVertex) const
+	{
+		return glm::vec3(NormalX[uiVertex], NormalY[uiVertex], NormalZ[uiVertex]);
+	}
+
+	inline void Clear()
+	{
+		*this = MeshData();
+	}
+};
+
+// ----------------------------------------------------------------------------
+
+// Load a mesh, the format is picked from the extension (.obj or .ply). The
+// file is memory mapped and parsed in place. On failure the reason is
+// printed, the mesh is left empty and false is returned.
+bool LoadMesh(const std::string& fileName, MeshData& mesh);
+
+// Wavefront OBJ: positions, normals and polygonal faces, which are split in
+// triangle fans. Normals indexed separately from the positions are assigned
+// to the position of the face corner using them.
+bool LoadOBJ(const std::string& fileName, MeshData& mesh);
+
+// Binary PLY, little or big endian: x/y/z and nx/ny/nz vertex properties and
+// the vertex_indices face list. Other elements and properties are skipped.
+bool LoadPLY(const std::string& fileName, MeshData& mesh);
+
+// ----------------------------------------------------------------------------
+
+#endif // __MESHLOADER_H__
\ No newline at end of file
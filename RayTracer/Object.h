@@ -3,6 +3,8 @@
 
 #include "Common.h"
 #include "Ray.h"
+#include "RayPacket.h"
+#include "AABB.h"
 
 // ----------------------------------------------------------------------------
 
@@ -18,6 +20,7 @@ enum ObjectType
 	kePOINTLIGHT,
 	keAREALIGHT,
 	keBOX,
+	keMESH,
 };
 
 // ----------------------------------------------------------------------------
@@ -59,6 +62,41 @@ public:
 	
 	virtual IntersectionInfo FindIntersection(const Ray& ray) { return IntersectionInfo(); }
 
+	// Any-hit query used by the shadow rays. Returns true if the object is hit
+	// between the ray origin and tMax. Objects override it with a test which
+	// doesn't calculate the normal or the intersection point. The scene never
+	// asks lights, they don't cast shadows.
+	virtual bool Occluded(const Ray& ray, float tMax)
+	{
+		IntersectionInfo intersection = FindIntersection(ray);
+		return intersection.RayLength > 0.0f && intersection.RayLength < tMax;
+	}
+
+	// Closest hits of the rays uiFirst to uiLast of a packet. The rays hitting
+	// the object before their entry of tMax get it shrunk to the hit distance
+	// and their result replaced. Objects with a hierarchy of their own
+	// override it to walk it once for all these rays.
+	virtual void IntersectPacket(const RayPacket& packet,
+		unsigned int uiFirst,
+		unsigned int uiLast,
+		float* tMax,
+		IntersectionInfo* results)
+	{
+		for (unsigned int index = uiFirst; index <= uiLast; index++)
+		{
+			IntersectionInfo intersection = FindIntersection(packet.Rays[index]);
+			if (intersection.RayLength > 0.0f && intersection.RayLength < tMax[index])
+			{
+				tMax[index] = intersection.RayLength;
+				results[index] = intersection;
+			}
+		}
+	}
+
+	// Returns false for unbounded objects (e.g. planes) which can't be stored
+	// in the scene's bounding volume hierarchy
+	virtual bool GetBoundingBox(AABB& /*bounds*/) { return false; }
+
 	virtual glm::vec3 GetPosition() = 0;
 	virtual void SetPosition(const glm::vec3& newPosition) = 0;
 
@@ -70,6 +108,13 @@ public:
 
 	inline const ObjectType Type() const { return m_Type; }
 
+	inline bool IsLight() const
+	{
+		return m_Type == ObjectType::kePOINTLIGHT ||
+			m_Type == ObjectType::keDIRECTIONALLIGHT ||
+			m_Type == ObjectType::keAREALIGHT;
+	}
+
 protected:
 
 	unsigned m_uIndex;
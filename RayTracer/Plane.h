@@ -32,6 +32,21 @@ public:
 	inline glm::vec3 GetPosition() { return m_vNormal; }
 	inline void SetPosition(const glm::vec3& newPosition) { m_vNormal = newPosition; }
 	
+	inline bool Occluded(const Ray& ray, float tMax)
+	{
+		float fNormalDotRay = glm::dot(m_vNormal, ray.GetDirection());
+
+		if (fNormalDotRay == 0.0f)
+		{
+			// The ray is parallel to the plane
+			return false;
+		}
+
+		float t = glm::dot(m_vPointOnPlane - ray.GetOrigin(), m_vNormal) / fNormalDotRay;
+
+		return t > Constants::EPS && t < tMax;
+	}
+
 	// Find distance from the Camera to the intersection point
 	inline IntersectionInfo FindIntersection(const Ray& ray)
 	{
@@ -0,0 +1,184 @@
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+#include <stdint.h>
+
+#include "glm/glm.hpp"
+
+// ----------------------------------------------------------------------------
+
+// Minimal PCG32 generator (XSH RR variant). It is small enough to keep one
+// per render thread, which avoids the global lock rand() takes.
+class PCG32
+{
+public:
+	PCG32(uint64_t ullSeed = 0, uint64_t ullStream = 0) { Seed(ullSeed, ullStream); }
+
+	inline void Seed(uint64_t ullSeed, uint64_t ullStream = 0)
+	{
+		m_ullState = 0;
+		m_ullIncrement = (ullStream << 1u) | 1u;
+		NextUInt();
+		m_ullState += ullSeed;
+		NextUInt();
+	}
+
+	inline uint32_t NextUInt()
+	{
+		uint64_t ullOldState = m_ullState;
+		m_ullState = ullOldState * 6364136223846793005ULL + m_ullIncrement;
+
+		uint32_t uiXorShifted = (uint32_t)(((ullOldState >> 18u) ^ ullOldState) >> 27u);
+		uint32_t uiRotation = (uint32_t)(ullOldState >> 59u);
+		return (uiXorShifted >> uiRotation) | (uiXorShifted << ((0u - uiRotation) & 31u));
+	}
+
+	// Uniform in [0, 1)
+	inline float NextFloat()
+	{
+		// The top 24 bits fit exactly in the float mantissa
+		return (NextUInt() >> 8) * (1.0f / 16777216.0f);
+	}
+
+private:
+	uint64_t m_ullState;
+	uint64_t m_ullIncrement;
+};
+
+// ----------------------------------------------------------------------------
+
+enum SamplePattern
+{
+	keSTRATIFIED = 0,		// One jittered sample per grid cell
+	keLOW_DISCREPANCY,		// Scrambled (0,2)-sequence over the whole square
+
+	keINVALID_SAMPLEPATTERN,
+};
+
+// ----------------------------------------------------------------------------
+
+// Per thread sample generator. Every pixel reseeds it from its coordinates,
+// the frame index and a global seed, so a pixel gets the same samples no
+// matter which worker renders it or in which order the tiles are processed.
+class Sampler
+{
+public:
+	inline void StartPixel(unsigned int uiX, unsigned int uiY, unsigned int uiFrame, unsigned int uiSeed)
+	{
+		uint64_t ullPixel = ((uint64_t)uiY << 32) | uiX;
+		uint64_t ullFrame = ((uint64_t)uiSeed << 32) | uiFrame;
+
+		m_Generator.Seed(Hash(ullPixel ^ Hash(ullFrame)), ullFrame);
+
+		// Same for every frame of the pixel
+		m_uiPixelKey = (uint32_t)Hash(ullPixel ^ Hash(uiSeed));
+	}
+
+	// Per pixel constant which offsets the progressive sample sequences, so
+	// neighbouring pixels don't take the same sample in the same frame
+	inline uint32_t GetPixelKey() const { return m_uiPixelKey; }
+
+	inline void SetPattern(SamplePattern ePattern) { m_ePattern = ePattern; }
+	inline SamplePattern GetPattern() const { return m_ePattern; }
+
+	inline uint32_t NextUInt() { return m_Generator.NextUInt(); }
+	inline float NextFloat() { return m_Generator.NextFloat(); }
+
+	// Copy with a generator of its own, seeded from this one, for samples
+	// which are taken out of order (e.g. the bounces of a wavefront). The
+	// pixel key and the pattern stay the same.
+	inline Sampler Split()
+	{
+		uint64_t ullSeed = ((uint64_t)NextUInt() << 32) | NextUInt();
+
+		Sampler split = *this;
+		split.m_Generator.Seed(Hash(ullSeed), ullSeed);
+		return split;
+	}
+
+	// Start a new set of square samples. The low discrepancy points of every
+	// set are scrambled differently so neighbouring pixels don't share them.
+	inline void StartSampleSet()
+	{
+		m_uiScrambleX = m_Generator.NextUInt();
+		m_uiScrambleY = m_Generator.NextUInt();
+	}
+
+	// Sample uiIndex of a uiCountX by uiCountY set in the unit square
+	inline glm::vec2 SquareSample(unsigned int uiIndex, unsigned int uiCountX, unsigned int uiCountY)
+	{
+		if (m_ePattern == keLOW_DISCREPANCY)
+		{
+			return glm::vec2(ToUnitFloat(VanDerCorput(uiIndex) ^ m_uiScrambleX),
+				ToUnitFloat(Sobol2(uiIndex) ^ m_uiScrambleY));
+		}
+
+		unsigned int uiColumn = uiIndex % uiCountX;
+		unsigned int uiRow = uiIndex / uiCountX;
+
+		return glm::vec2((uiColumn + NextFloat()) / uiCountX,
+			(uiRow + NextFloat()) / uiCountY);
+	}
+
+	// ------------------------------------------------------------------------
+
+	// SplitMix64 finalizer
+	static inline uint64_t Hash(uint64_t ullValue)
+	{
+		ullValue += 0x9E3779B97F4A7C15ULL;
+		ullValue = (ullValue ^ (ullValue >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		ullValue = (ullValue ^ (ullValue >> 27)) * 0x94D049BB133111EBULL;
+		return ullValue ^ (ullValue >> 31);
+	}
+
+	// First dimension of the Sobol sequence, base 2 radical inverse
+	static inline uint32_t VanDerCorput(uint32_t uiIndex)
+	{
+		uiIndex = (uiIndex << 16) | (uiIndex >> 16);
+		uiIndex = ((uiIndex & 0x00FF00FFu) << 8) | ((uiIndex & 0xFF00FF00u) >> 8);
+		uiIndex = ((uiIndex & 0x0F0F0F0Fu) << 4) | ((uiIndex & 0xF0F0F0F0u) >> 4);
+		uiIndex = ((uiIndex & 0x33333333u) << 2) | ((uiIndex & 0xCCCCCCCCu) >> 2);
+		uiIndex = ((uiIndex & 0x55555555u) << 1) | ((uiIndex & 0xAAAAAAAAu) >> 1);
+		return uiIndex;
+	}
+
+	// Second dimension of the Sobol sequence
+	static inline uint32_t Sobol2(uint32_t uiIndex)
+	{
+		uint32_t uiResult = 0;
+		for (uint32_t uiDirection = 1u << 31; uiIndex != 0; uiIndex >>= 1, uiDirection ^= uiDirection >> 1)
+		{
+			if (uiIndex & 1)
+			{
+				uiResult ^= uiDirection;
+			}
+		}
+		return uiResult;
+	}
+
+	static inline float ToUnitFloat(uint32_t uiValue)
+	{
+		return (uiValue >> 8) * (1.0f / 16777216.0f);
+	}
+
+private:
+	PCG32 m_Generator;
+	SamplePattern m_ePattern = keSTRATIFIED;
+
+	uint32_t m_uiScrambleX = 0;
+	uint32_t m_uiScrambleY = 0;
+	uint32_t m_uiPixelKey = 0;
+};
+
+// ----------------------------------------------------------------------------
+
+// Sampler of the calling thread
+inline Sampler& GetThreadSampler()
+{
+	static thread_local Sampler sampler;
+	return sampler;
+}
+
+// ----------------------------------------------------------------------------
+
+#endif // __RANDOM_H__
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef __RAYPACKET_H__
+#define __RAYPACKET_H__
+
+#include <cmath>
+#include <limits>
+
+#include "Common.h"
+#include "Ray.h"
+
+// ----------------------------------------------------------------------------
+
+// Rays sharing their origin, e.g. the primary rays of a block of pixels. If
+// the directions have the same sign on every axis the packet is coherent: the
+// reciprocal directions then fit in one interval per axis, and the intervals
+// bound the whole packet when it is tested against a box.
+struct RayPacket
+{
+	static const unsigned int MAX_SIZE = 64;
+
+	RayPacket()
+		: Count(0), Coherent(false)
+	{ }
+
+	inline void Reset(const glm::vec3& origin)
+	{
+		Origin = origin;
+		Count = 0;
+		Coherent = false;
+	}
+
+	// The ray must start at the packet's origin
+	inline void Add(const Ray& ray)
+	{
+		Rays[Count++] = ray;
+	}
+
+	// Compute the direction intervals once all the rays are added
+	inline void Finalize()
+	{
+		InvDirectionMin = glm::vec3(std::numeric_limits<float>::infinity());
+		InvDirectionMax = glm::vec3(-std::numeric_limits<float>::infinity());
+
+		unsigned int uiNegativeCount[3] = { 0, 0, 0 };
+
+		for (unsigned int index = 0; index < Count; index++)
+		{
+			const glm::vec3& direction = Rays[index].GetDirection();
+			glm::vec3 invDirection = 1.0f / direction;
+
+			InvDirectionMin = glm::min(InvDirectionMin, invDirection);
+			InvDirectionMax = glm::max(InvDirectionMax, invDirection);
+
+			for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+			{
+				// The sign of zero counts too, it picks the infinity of 1 / 0
+				uiNegativeCount[uiAxis] += std::signbit(direction[uiAxis]) ? 1 : 0;
+			}
+		}
+
+		Coherent = Count > 0;
+		for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+		{
+			Coherent = Coherent && (uiNegativeCount[uiAxis] == 0 || uiNegativeCount[uiAxis] == Count);
+		}
+	}
+
+	glm::vec3 Origin;
+
+	Ray Rays[MAX_SIZE];
+	unsigned int Count;
+
+	// Reciprocal direction bounds over the rays, only valid when coherent
+	glm::vec3 InvDirectionMin;
+	glm::vec3 InvDirectionMax;
+	bool Coherent;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __RAYPACKET_H__
\ No newline at end of file
@@ -0,0 +1,130 @@
+#ifndef __RAYQUEUE_H__
+#define __RAYQUEUE_H__
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+#include "Common.h"
+#include "Ray.h"
+#include "AABB.h"
+
+// ----------------------------------------------------------------------------
+
+// Sort key of the rays of a stream: the octant of the direction, then the
+// Morton code of the origin's cell on a grid over the scene. Rays next to
+// each other in key order start close together and go the same way, so they
+// visit mostly the same nodes and objects.
+class RayStreamOrder
+{
+public:
+	// Cells per axis, 2^9 so the three Morton coordinates and the octant fit
+	// in 30 bits
+	static const unsigned int GRID_BITS = 9;
+
+	explicit RayStreamOrder(const AABB& bounds)
+	{
+		// Origins outside the bounds (e.g. on a plane) fall in the border cells
+		m_vOrigin = bounds.IsValid() ? bounds.Min : glm::vec3(0.0f);
+
+		glm::vec3 extent = bounds.IsValid() ? bounds.Extent() : glm::vec3(1.0f);
+		m_vCellScale = (float)(1u << GRID_BITS) / glm::max(extent, glm::vec3(1e-6f));
+	}
+
+	inline uint32_t Key(const Ray& ray) const
+	{
+		const glm::vec3& direction = ray.GetDirection();
+		uint32_t uiOctant = (direction.x < 0.0f ? 1u : 0u) | (direction.y < 0.0f ? 2u : 0u) | (direction.z < 0.0f ? 4u : 0u);
+
+		glm::vec3 cell = glm::clamp((ray.GetOrigin() - m_vOrigin) * m_vCellScale,
+			glm::vec3(0.0f), glm::vec3((float)((1u << GRID_BITS) - 1)));
+
+		uint32_t uiMorton = SpreadBits((uint32_t)cell.x) |
+			(SpreadBits((uint32_t)cell.y) << 1) |
+			(SpreadBits((uint32_t)cell.z) << 2);
+
+		return (uiOctant << (3 * GRID_BITS)) | uiMorton;
+	}
+
+private:
+	glm::vec3 m_vOrigin;
+	glm::vec3 m_vCellScale;
+
+	// Put two zero bits between the low 10 bits of the value
+	static inline uint32_t SpreadBits(uint32_t uiValue)
+	{
+		uiValue &= 0x3FFu;
+		uiValue = (uiValue | (uiValue << 16)) & 0x030000FFu;
+		uiValue = (uiValue | (uiValue << 8)) & 0x0300F00Fu;
+		uiValue = (uiValue | (uiValue << 4)) & 0x030C30C3u;
+		uiValue = (uiValue | (uiValue << 2)) & 0x09249249u;
+		return uiValue;
+	}
+};
+
+// ----------------------------------------------------------------------------
+
+// Rays waiting to be traced together, e.g. one bounce generation of a tile.
+// The entries stay where they were pushed, Sort only computes the order in
+// which to process them. Entry must have a Ray member named TracedRay.
+template <typename Entry>
+class RayQueue
+{
+public:
+	inline void Clear()
+	{
+		m_vEntries.clear();
+		m_vOrder.clear();
+	}
+
+	inline void Push(const Entry& entry) { m_vEntries.push_back(entry); }
+
+	inline bool Empty() const { return m_vEntries.empty(); }
+	inline unsigned int Size() const { return (unsigned int)m_vEntries.size(); }
+
+	inline Entry& operator[](unsigned int uiIndex) { return m_vEntries[uiIndex]; }
+	inline const Entry& operator[](unsigned int uiIndex) const { return m_vEntries[uiIndex]; }
+
+	// Order the entries by the keys of their rays. Equal keys keep the order
+	// they were pushed in.
+	inline void Sort(const RayStreamOrder& order)
+	{
+		m_vOrder.resize(m_vEntries.size());
+		for (size_t index = 0; index < m_vEntries.size(); index++)
+		{
+			m_vOrder[index] = ((uint64_t)order.Key(m_vEntries[index].TracedRay) << 32) | (uint64_t)index;
+		}
+
+		std::sort(m_vOrder.begin(), m_vOrder.end());
+	}
+
+	// Keep the order the entries were pushed in, for rays which are coherent
+	// already (e.g. the primary rays of a tile)
+	inline void KeepOrder()
+	{
+		m_vOrder.resize(m_vEntries.size());
+		for (size_t index = 0; index < m_vEntries.size(); index++)
+		{
+			m_vOrder[index] = (uint64_t)index;
+		}
+	}
+
+	// Index of the entry at the given position of the sorted order
+	inline unsigned int Sorted(unsigned int uiPosition) const { return (unsigned int)m_vOrder[uiPosition]; }
+
+	inline void Swap(RayQueue& other)
+	{
+		m_vEntries.swap(other.m_vEntries);
+		m_vOrder.swap(other.m_vOrder);
+	}
+
+private:
+	std::vector<Entry> m_vEntries;
+
+	// Sort key in the high half, entry index in the low half
+	std::vector<uint64_t> m_vOrder;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __RAYQUEUE_H__
\ No newline at end of file
@@ -0,0 +1,3034 @@
+#include "Renderer.h"
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <utility>
+#include <cmath>
+#include <limits>
+#include <atomic>
+#include <algorithm>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Object.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Ray.h"
+#include "DirectionalLight.h"
+#include "PointLight.h"
+#include "Box.h"
+#include "Random.h"
+#include "RayQueue.h"
+#include "TileDependencies.h"
+
+// ------------------------------------------------------------------------
+
+// Multithreading
+#define MULTITHREADING
+
+// SSE2 is available on every x64 target and on x86 builds with /arch:SSE2,
+// which is the default since Visual Studio 2012
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TONEMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+// Tiles are small so the expensive parts of the image (reflective and
+// refractive objects) get spread over all the workers
+const unsigned int iTileSize = 16;
+
+// Side of the pixel blocks whose primary rays are traced as one packet
+const unsigned int iPacketBlockSize = 8;
+
+#ifdef MULTITHREADING
+
+std::unique_ptr<TileScheduler> m_TileScheduler;
+
+#endif // MULTITHREADING
+
+// ------------------------------------------------------------------------
+// Modifiable values from the UI
+unsigned int MAX_REFLECTION_DEPTH = 5;
+unsigned int MAX_REFRACTION_DEPTH = 5;
+
+int SquareLength = 5;
+int SampleCount = 10;
+float SampleDistance = 1.0f / SampleCount;
+
+const float AmbientRefractiveIndex = 1.0003f;
+
+bool UpdateRequired = true;
+bool Realtime = false;
+bool ShadowsEnabled = false;
+bool SoftShadowsEnabled = false;
+bool SuperSamplingEnabled = false;
+bool PlaneTexturingEnabled = false;
+bool ReflectionEnabled = false;
+bool RefractionEnabled = false;
+bool ProgressiveEnabled = true;
+bool PacketTracingEnabled = true;
+bool WavefrontEnabled = false;
+
+float ContributionThreshold = 1.0f / 512.0f;
+bool RussianRouletteEnabled = false;
+
+bool GBufferEnabled = true;
+
+bool DirtyTilesEnabled = true;
+
+bool ReprojectionEnabled = true;
+
+unsigned int AreaLightSampleLimit = 0;
+
+bool AdaptiveSuperSamplingEnabled = true;
+
+LightingModel eLightModel = LightingModel::BlinnPhong;
+
+SamplePattern eSamplePattern = SamplePattern::keSTRATIFIED;
+unsigned int RandomSeed = 0;
+
+// -----------------------------------------------------------------------------
+// Frame
+
+unsigned int iWidth = 0;
+unsigned int iHeight = 0;
+sf::Uint8* pixels = nullptr;
+glm::vec4* accumulation = nullptr;
+
+Scene scene;
+std::shared_ptr<Camera> pCam;
+
+// Part of the per pixel seed so consecutive frames get different samples
+unsigned int uiFrameIndex = 0;
+
+// -----------------------------------------------------------------------------
+// Progressive accumulation
+
+// Past this many samples per pixel the image is left as it is until
+// something changes
+const unsigned int iProgressiveSampleLimit = 4096;
+
+// Everything the image depends on besides the scene objects. The average
+// restarts whenever one of these changes.
+struct FrameSignature
+{
+	glm::vec3 CameraPosition;
+	glm::vec3 CameraTarget;
+	glm::vec3 CameraUp;
+
+	unsigned int MaxReflectionDepth;
+	unsigned int MaxRefractionDepth;
+	int SquareLength;
+	int SampleCount;
+
+	bool ShadowsEnabled;
+	bool SoftShadowsEnabled;
+	bool SuperSamplingEnabled;
+	bool AdaptiveSuperSamplingEnabled;
+	bool PlaneTexturingEnabled;
+	bool ReflectionEnabled;
+	bool RefractionEnabled;
+
+	float ContributionThreshold;
+	bool RussianRouletteEnabled;
+	unsigned int AreaLightSampleLimit;
+
+	LightingModel LightModel;
+	SamplePattern Pattern;
+	unsigned int Seed;
+
+	bool operator==(const FrameSignature& other) const
+	{
+		return CameraPosition == other.CameraPosition &&
+			CameraTarget == other.CameraTarget &&
+			CameraUp == other.CameraUp &&
+			SameSettings(other);
+	}
+
+	// Everything but the camera
+	bool SameSettings(const FrameSignature& other) const
+	{
+		return MaxReflectionDepth == other.MaxReflectionDepth &&
+			MaxRefractionDepth == other.MaxRefractionDepth &&
+			SquareLength == other.SquareLength &&
+			SampleCount == other.SampleCount &&
+			ShadowsEnabled == other.ShadowsEnabled &&
+			SoftShadowsEnabled == other.SoftShadowsEnabled &&
+			SuperSamplingEnabled == other.SuperSamplingEnabled &&
+			AdaptiveSuperSamplingEnabled == other.AdaptiveSuperSamplingEnabled &&
+			PlaneTexturingEnabled == other.PlaneTexturingEnabled &&
+			ReflectionEnabled == other.ReflectionEnabled &&
+			RefractionEnabled == other.RefractionEnabled &&
+			ContributionThreshold == other.ContributionThreshold &&
+			RussianRouletteEnabled == other.RussianRouletteEnabled &&
+			AreaLightSampleLimit == other.AreaLightSampleLimit &&
+			LightModel == other.LightModel &&
+			Pattern == other.Pattern &&
+			Seed == other.Seed;
+	}
+};
+
+FrameSignature lastFrameSignature;
+
+// Set for the whole frame by RenderFrame, read by the workers
+bool bProgressiveFrame = false;
+
+// Samples per pixel already in the accumulation buffer
+unsigned int uiProgressiveSampleCount = 0;
+
+// -----------------------------------------------------------------------------
+// Primary hit cache (G-buffer)
+
+// Everything the primary rays depend on besides the geometry
+struct CameraSignature
+{
+	glm::vec3 Position;
+	glm::vec3 Target;
+	glm::vec3 Up;
+	float HorizontalFOV;
+	float VerticalFOV;
+
+	bool operator==(const CameraSignature& other) const
+	{
+		return Position == other.Position &&
+			Target == other.Target &&
+			Up == other.Up &&
+			HorizontalFOV == other.HorizontalFOV &&
+			VerticalFOV == other.VerticalFOV;
+	}
+};
+
+// Basis of the primary rays of a camera, the same as in Draw
+struct CameraFrame
+{
+	explicit CameraFrame(const CameraSignature& camera)
+		: Position(camera.Position)
+	{
+		W = glm::normalize(camera.Position - camera.Target);
+		U = glm::normalize(glm::cross(camera.Up, W));
+		V = glm::normalize(glm::cross(W, U));
+
+		TanHalfHorizFOV = glm::tan(rad(camera.HorizontalFOV / 2.0f));
+		TanHalfVertFOV = glm::tan(rad(camera.VerticalFOV / 2.0f));
+	}
+
+	// Image position (fX, fY) whose primary ray goes through the point, the
+	// inverse of the mapping in Draw. False for points behind the camera.
+	inline bool Project(const glm::vec3& point, glm::vec2& pixel) const
+	{
+		glm::vec3 toPoint = point - Position;
+
+		float fDepth = -glm::dot(toPoint, W);
+		if (fDepth <= Constants::EPS)
+		{
+			return false;
+		}
+
+		pixel.x = iWidth * 0.5f * (1.0f - glm::dot(toPoint, U) / (fDepth * TanHalfHorizFOV));
+		pixel.y = iHeight * 0.5f * (1.0f - glm::dot(toPoint, V) / (fDepth * TanHalfVertFOV));
+		return true;
+	}
+
+	// Primary ray through the image position (fX, fY)
+	inline Ray PrimaryRay(float fX, float fY) const
+	{
+		float fHalfWidth = iWidth * 0.5f;
+		float fHalfHeight = iHeight * 0.5f;
+
+		float fAlpha = TanHalfHorizFOV * ((fHalfWidth - fX) / fHalfWidth);
+		float fBeta = TanHalfVertFOV * ((fHalfHeight - fY) / fHalfHeight);
+
+		return Ray(Position, glm::normalize(fAlpha * U + fBeta * V - W));
+	}
+
+	glm::vec3 Position;
+	glm::vec3 U, V, W;
+	float TanHalfHorizFOV;
+	float TanHalfVertFOV;
+};
+
+enum GBufferUse
+{
+	keGBUFFER_UNUSED = 0,		// The frame traces its primary rays
+	keGBUFFER_STORE,			// The frame traces them and keeps their hits
+	keGBUFFER_REUSE,			// The frame shades the kept hits again
+};
+
+// Closest hit (position, normal, distance and object, which gives the
+// material) of every pixel's primary ray. It holds while the camera and the
+// geometry don't change, so light, material and render setting changes only
+// shade the pixels again.
+std::vector<IntersectionInfo> gBuffer;
+CameraSignature gBufferCamera;
+bool bGBufferValid = false;
+
+// Set for the whole frame by RenderFrame, read by the workers
+GBufferUse eGBufferUse = keGBUFFER_UNUSED;
+
+// The G-buffer held the hit of every pixel after the last frame which was
+// drawn, even if the geometry changed since
+bool bGBufferFilled = false;
+
+// -----------------------------------------------------------------------------
+// Dirty tiles
+
+// What the rays of every tile depended on in the last frame which traced it.
+// Indexed by the tile's row and column on the iTileSize grid.
+std::vector<TileDependencies> tileDependencies;
+FrameSignature dependencySignature;
+CameraSignature dependencyCamera;
+bool bDependenciesValid = false;
+
+// Objects moved since the last frame which was drawn
+std::vector<ObjectMove> pendingMoves;
+
+// Set for the whole frame by RenderFrame, read by the workers. A partial
+// frame only traces the dirty tiles, the others keep their pixels.
+bool bRecordDependencies = false;
+bool bPartialFrame = false;
+std::vector<bool> dirtyTiles;
+
+unsigned int uiTracedTileCount = 0;
+
+// Dependencies of the tile the worker is tracing, null if they aren't recorded
+inline TileDependencies*& GetThreadTileDependencies()
+{
+	static thread_local TileDependencies* pDependencies = nullptr;
+	return pDependencies;
+}
+
+inline unsigned int GetTileColumnCount()
+{
+	return (iWidth + iTileSize - 1) / iTileSize;
+}
+
+inline unsigned int GetTileIndex(const Tile& tile)
+{
+	return (tile.StartY / iTileSize) * GetTileColumnCount() + tile.StartX / iTileSize;
+}
+
+// -----------------------------------------------------------------------------
+// Temporal reprojection
+
+// A pixel reuses the color of the last frame's pixel its hit falls in if
+// both see the same point of the same object: the hit's distance to the
+// last camera is within this fraction of the last frame's hit distance...
+const float fReprojectionDepthTolerance = 0.01f;
+
+// ...and the normals are about the same
+const float fReprojectionMinNormalCosine = 0.95f;
+
+// The color of view dependent materials (specular, reflective or refractive)
+// is only reused while the direction the point is seen from turned by less
+// than this many degrees since it was shaded
+const float fReprojectionMaxViewAngle = 1.0f;
+
+// Every reprojection moves a color by up to half a pixel, since it is taken
+// from the nearest pixel. A color is only reused while the point it was
+// shaded at stays within this many pixels of the hit.
+const float fReprojectionMaxDrift = 0.5f;
+
+// Where the color of a pixel was shaded, kept along with the G-buffer
+struct ShadingOrigin
+{
+	glm::vec3 CameraPosition;
+	glm::vec3 SurfacePoint;
+};
+
+std::vector<ShadingOrigin> shadingOrigins;
+
+// Hits, colors and shading origins of the last frame which was drawn. A
+// frame which reprojects them swaps them with its own buffers first.
+std::vector<IntersectionInfo> historyHits;
+std::vector<ShadingOrigin> historyShadingOrigins;
+glm::vec4* historyColors = nullptr;
+CameraSignature historyCamera;
+FrameSignature historySignature;
+bool bHistoryValid = false;
+
+// Set for the whole frame by RenderFrame, read by the workers
+bool bReprojectFrame = false;
+
+std::atomic<unsigned int> uiReprojectedPixelCount(0);
+
+// -----------------------------------------------------------------------------
+// Adaptive super sampling
+
+// Samples whose colors, clamped to the displayed range, differ by more than
+// this on a channel lie on different sides of an edge
+const float fAdaptiveContrastThreshold = 0.1f;
+
+// Set for the whole frame by RenderFrame, read by the workers. The frame
+// first takes the sample in the middle of every pixel, then refines the
+// pixels on edges.
+bool bAdaptiveFrame = false;
+
+// Levels of quarters the edge pixels are split into, 4^depth samples at most
+unsigned int uiAdaptiveDepth = 1;
+
+// Middle samples of the frame, the refinement of a tile reads the ones of the
+// neighbouring tiles too
+glm::vec4* centerColors = nullptr;
+
+std::atomic<unsigned int> uiRefinedPixelCount(0);
+
+// -----------------------------------------------------------------------------
+// Render features
+
+// Trace, Shade and FindColor are instantiated once per combination of these flags,
+// so the disabled features and the lighting model switch are resolved at
+// compile time instead of on every ray
+enum RenderFeature : unsigned int
+{
+	keFEATURE_PLANE_TEXTURING	= 1 << 0,
+	keFEATURE_SHADOWS			= 1 << 1,
+	keFEATURE_SOFT_SHADOWS		= 1 << 2,
+	keFEATURE_REFLECTION		= 1 << 3,
+	keFEATURE_REFRACTION		= 1 << 4,
+	keFEATURE_BLINN_PHONG		= 1 << 5,
+
+	keFEATURE_COMBINATION_COUNT	= 1 << 6,
+};
+
+typedef void(*TraceFunction)(const Ray& ray,
+	Radiance& colorAccumulator,
+	Scene& scene,
+	unsigned int iReflectionDepth,
+	unsigned int iRefractionDepth,
+	float fRefractiveIndex);
+
+typedef void(*ShadeFunction)(const Ray& ray,
+	const IntersectionInfo& intersect,
+	Radiance& colorAccumulator,
+	Scene& scene,
+	unsigned int iReflectionDepth,
+	unsigned int iRefractionDepth,
+	float fRefractiveIndex);
+
+// Reflected or refracted ray spawned by a hit, and the factor its color is
+// added to the hit's color with
+struct SecondaryRay
+{
+	Ray TracedRay;
+	float Weight;
+};
+
+// Ray of a pixel's ray tree waiting to be traced, with the product of the
+// weights along its path
+struct PendingRay
+{
+	Ray TracedRay;
+	float Weight;
+	unsigned int ReflectionDepth;
+	unsigned int RefractionDepth;
+};
+
+// Explicit stack of the depth first traversal of the ray trees, the depths
+// can be set to anything from the UI
+inline std::vector<PendingRay>& GetThreadPendingRays()
+{
+	static thread_local std::vector<PendingRay> pendingRays;
+	return pendingRays;
+}
+
+// -----------------------------------------------------------------------------
+// Wavefront
+
+// Ray of a bounce generation, traced for the pixel Slot of the tile
+struct QueuedRay
+{
+	Ray TracedRay;
+
+	// Samples of the path the ray continues, split from its parent's so the
+	// order in which the rays are traced doesn't matter
+	Sampler PathSampler;
+
+	// Factor of the ray's color in the pixel
+	float Weight;
+
+	unsigned int Slot;
+	unsigned int ReflectionDepth;
+	unsigned int RefractionDepth;
+};
+
+// Shadow ray towards a directional or point light from the hit of the
+// generation's ray number Hit
+struct QueuedShadowRay
+{
+	Ray TracedRay;
+	float MaxDistance;
+	unsigned int Hit;
+};
+
+// Buffers of a worker's wavefront, kept from one tile to the next
+struct WavefrontQueues
+{
+	RayQueue<QueuedRay> Rays;
+	RayQueue<QueuedRay> NextRays;
+	RayQueue<QueuedShadowRay> ShadowRays;
+
+	// Closest hit and hard shadow factor of every ray of the generation
+	std::vector<IntersectionInfo> Hits;
+	std::vector<float> Shade;
+
+	// Accumulated color and image index of every pixel of the tile
+	std::vector<Radiance> Colors;
+	std::vector<int> Pixels;
+};
+
+inline WavefrontQueues& GetThreadWavefrontQueues()
+{
+	static thread_local WavefrontQueues queues;
+	return queues;
+}
+
+typedef void(*WavefrontFunction)(WavefrontQueues& queues, bool bPrimaryHitsFound, Scene& scene);
+
+// Primary ray entry points for the current frame, chosen by RenderFrame.
+// Shade starts from a hit which was already found, e.g. by a packet.
+TraceFunction pTraceFunction = nullptr;
+ShadeFunction pShadeFunction = nullptr;
+WavefrontFunction pWavefrontFunction = nullptr;
+
+// -----------------------------------------------------------------------------
+// Forward declarations
+
+void Draw(const Tile& tile);
+void DrawTile(const Tile& tile);
+void Render(const Tile& tile);
+void Tonemap(const Tile& tile);
+CameraSignature CurrentCameraSignature();
+
+IntersectionInfo RaySceneIntersection(const Ray& ray, Scene& scene);
+
+template <unsigned int Features>
+Radiance FindColor(const IntersectionInfo& intersect, const Material& hitObjectMaterial, Scene& scene, float fShade);
+void CalculateSquareCoord(int intersectionX, int intersectionZ, int& coordX, int& coordZ);
+
+// -----------------------------------------------------------------------------
+
+float mix(const float& t1, const float& t2, const float& mix)
+{
+	return t2 * mix + t1 * (1.0f - mix);
+}
+
+// -----------------------------------------------------------------------------
+
+Radiance PhongLighting(DirectionalLight& currentLight, 
+	const Material& material,
+	const glm::vec3& position,
+	const glm::vec3& normal,
+	float fShade)
+{
+	Radiance ambientComponent, diffuseComponent(0.0f), specularComponent(0.0f);
+
+	// Ambient component
+	ambientComponent = ToRadiance(currentLight.AmbientLight) * ToRadiance(material.Ambient);
+
+	if (fShade == 0.0f)
+	{
+		// Return the final color
+		return ambientComponent;
+	}
+	else
+	{
+		// Diffuse component
+		glm::vec3 lightDirection = glm::normalize(currentLight.Direction);
+		float fNormalDotLight = glm::max(glm::dot(normal, lightDirection), 0.0f);
+		Radiance diffuseResult = ToRadiance(material.Diffuse) * ToRadiance(currentLight.DiffuseLight);
+		diffuseComponent = diffuseResult * fNormalDotLight * fShade;
+
+		// Specular component
+		vec3 viewDirection = glm::normalize(pCam->GetCameraPosition() - position);
+		vec3 reflectionDirection = glm::reflect<vec3>(-lightDirection, normal);
+		float specular = std::pow(std::max(glm::dot(viewDirection, reflectionDirection), 0.0f), material.Shininess) * fShade;
+		Radiance specularResult = ToRadiance(material.Specular) * ToRadiance(currentLight.SpecularLight);
+		specularComponent = specularResult * specular;
+
+		// Return the final color
+		return ambientComponent + diffuseComponent + specularComponent;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+Radiance PhongLighting(PointLight& currentLight,
+	const Material& material,
+	const glm::vec3& position,
+	const glm::vec3& normal,
+	float fShade)
+{
+	Radiance ambientComponent, diffuseComponent(0.0f), specularComponent(0.0f);
+
+	// Ambient component
+	ambientComponent = ToRadiance(currentLight.AmbientLight) * ToRadiance(material.Ambient);
+
+	if (fShade == 0.0f)
+	{
+		// Return the final color
+		return ambientComponent;
+	}
+	else
+	{
+		// Diffuse component
+
+		// Calculate the light vector
+		glm::vec3 lightVector = currentLight.Position - position;
+		// Calculate the distance from the point light to the pixel position
+		float distance = glm::length(lightVector);
+		//// Calculate the attenuation factor
+		//float attenuation = 1.0f / (currentLight.ConstantAttenuation +
+		//	currentLight.LinearAttenuation * distance +
+		//	currentLight.QuadraticAttenuation * (distance * distance));
+		glm::vec3 lightDirection = glm::normalize(lightVector);
+		float fNormalDotLight = glm::dot(normal, lightDirection);
+		if (fNormalDotLight > 0.0f)
+		{
+			Radiance diffuseResult = ToRadiance(material.Diffuse) * ToRadiance(currentLight.DiffuseLight);
+
+			diffuseComponent = diffuseResult * fNormalDotLight * fShade;
+		}
+
+		// Specular component
+		vec3 viewDirection = glm::normalize(pCam->GetCameraPosition() - position);
+		vec3 reflectionDirection = glm::reflect<vec3>(-lightDirection, normal);
+		float specular = std::pow(std::max(glm::dot(viewDirection, reflectionDirection), 0.0f), material.Shininess) * fShade;
+		Radiance specularResult = ToRadiance(material.Specular) * ToRadiance(currentLight.SpecularLight);
+		specularComponent = specularResult * specular;
+
+		// Return the final color
+		return (ambientComponent + diffuseComponent + specularComponent);// *attenuation;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+// Shadow test between a surface point and a point on an area light
+bool AreaLightSampleOccluded(Scene& scene, const glm::vec3& position, const glm::vec3& samplePoint)
+{
+	glm::vec3 shadowVector = samplePoint - position;
+	float distance = glm::length(shadowVector);
+	glm::vec3 shadowVectorDirection = shadowVector / distance;
+
+	Ray shadowRay(position + shadowVectorDirection * Constants::EPS, shadowVectorDirection);
+
+	// Anything on the segment to the sample blocks it
+	return scene.Occluded(shadowRay, distance);
+}
+
+// -----------------------------------------------------------------------------
+
+// The shadow rays from a surface point to the samples of an area light are
+// recorded at once, as the segments to the light's bounds. The samples lie
+// EPS under the light and the rays end EPS behind them.
+void RecordAreaLightShadowRays(AreaLight& currentLight, const glm::vec3& position)
+{
+	TileDependencies* pDependencies = GetThreadTileDependencies();
+	if (pDependencies == nullptr)
+	{
+		return;
+	}
+
+	AABB lightBounds;
+	currentLight.GetBoundingBox(lightBounds);
+
+	glm::vec3 margin(2.0f * Constants::EPS);
+	pDependencies->AddShadowRays(position, AABB(lightBounds.Min - margin, lightBounds.Max + margin));
+}
+
+// -----------------------------------------------------------------------------
+
+// Light samples evaluated at one surface point. The full set is taken at
+// once, except in progressive frames which take a single sample. The pixel
+// key and the frame's sample count pick it, so over consecutive frames every
+// pixel goes through all the cells of the set. Under a sample limit the other
+// frames take a run of cells which moves on the same way with the frame
+// index.
+void GetAreaLightSampleRange(const AreaLight& currentLight,
+	const Sampler& sampler,
+	unsigned int& uiFirstSample,
+	unsigned int& uiSampleCount)
+{
+	unsigned int uiSetSize = currentLight.GetSampleCountX() * currentLight.GetSampleCountZ();
+
+	if (bProgressiveFrame == true)
+	{
+		uiFirstSample = (sampler.GetPixelKey() + uiProgressiveSampleCount) % uiSetSize;
+		uiSampleCount = 1;
+	}
+	else if (AreaLightSampleLimit > 0 && AreaLightSampleLimit < uiSetSize)
+	{
+		uiFirstSample = (sampler.GetPixelKey() + uiFrameIndex * AreaLightSampleLimit) % uiSetSize;
+		uiSampleCount = AreaLightSampleLimit;
+	}
+	else
+	{
+		uiFirstSample = 0;
+		uiSampleCount = uiSetSize;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+Radiance PhongLighting(AreaLight& currentLight,
+	const Material& material,
+	const glm::vec3& position,
+	const glm::vec3& normal,
+	Scene& scene,
+	bool bSampleLight)
+{
+	// Ambient component
+	Radiance ambientComponent = ToRadiance(currentLight.AmbientLight) * ToRadiance(material.Ambient);
+
+	if (bSampleLight == false)
+	{
+		// Return the final color
+		return ambientComponent;
+	}
+	else
+	{
+		// Sum of the diffuse and specular factors of the visible samples. The
+		// light and material colors are the same for every sample.
+		float fDiffuseSum = 0.0f;
+		float fSpecularSum = 0.0f;
+
+		unsigned int sampleCountX = currentLight.GetSampleCountX();
+		unsigned int sampleCountZ = currentLight.GetSampleCountZ();
+
+		// Draw the light samples from this thread's generator
+		Sampler& sampler = GetThreadSampler();
+		sampler.StartSampleSet();
+
+		unsigned int uiFirstSample, uiSampleCount;
+		GetAreaLightSampleRange(currentLight, sampler, uiFirstSample, uiSampleCount);
+
+		vec3 viewDirection = glm::normalize(pCam->GetCameraPosition() - position);
+
+		RecordAreaLightShadowRays(currentLight, position);
+
+		for (unsigned int sample = 0; sample < uiSampleCount; sample++)
+		{
+			unsigned int uiSampleIndex = (uiFirstSample + sample) % (sampleCountX * sampleCountZ);
+
+			// Calculate the position of the next sample. The same point is
+			// used for the shadow test and for shading.
+			glm::vec3 currentSamplePoint = currentLight.GetSamplePoint(
+				sampler.SquareSample(uiSampleIndex, sampleCountX, sampleCountZ));
+
+			glm::vec3 lightDirection = glm::normalize(currentSamplePoint - position);
+
+			// Diffuse component
+			float fNormalDotLight = glm::max(glm::dot(normal, lightDirection), 0.0f);
+
+			// Specular component
+			vec3 reflectionDirection = glm::reflect<vec3>(-lightDirection, normal);
+			float specular = std::pow(std::max(glm::dot(viewDirection, reflectionDirection), 0.0f), material.Shininess);
+
+			// Samples which don't contribute don't need a shadow ray
+			if (fNormalDotLight == 0.0f && specular == 0.0f)
+			{
+				continue;
+			}
+
+			if (AreaLightSampleOccluded(scene, position, currentSamplePoint))
+			{
+				continue;
+			}
+
+			fDiffuseSum += fNormalDotLight;
+			fSpecularSum += specular;
+		}
+
+		Radiance diffuseResult = ToRadiance(material.Diffuse) * ToRadiance(currentLight.DiffuseLight);
+		Radiance specularResult = ToRadiance(material.Specular) * ToRadiance(currentLight.SpecularLight);
+
+		float fSampleScale = 1.0f / uiSampleCount;
+
+		// Return the final color
+		return ambientComponent + (diffuseResult * fDiffuseSum + specularResult * fSpecularSum) * fSampleScale;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+Radiance BlinnPhongLighting(DirectionalLight& currentLight,
+	const Material& material,
+	const glm::vec3& position,
+	const glm::vec3& normal,
+	float fShade)
+{
+	Radiance ambientComponent, diffuseComponent(0.0f), specularComponent(0.0f);
+
+	// Ambient component
+	ambientComponent = ToRadiance(currentLight.AmbientLight) * ToRadiance(material.Ambient);
+
+	if (fShade == 0.0f)
+	{
+		// Return the final color
+		return ambientComponent;
+	}
+	else
+	{
+		// Diffuse component
+		glm::vec3 lightDirection = glm::normalize(currentLight.Direction);
+		float fNormalDotLight = glm::max(glm::dot(normal, lightDirection), 0.0f);
+		Radiance diffuseResult = ToRadiance(material.Diffuse) * ToRadiance(currentLight.DiffuseLight);
+		diffuseComponent = diffuseResult * fNormalDotLight * fShade;
+
+		// Specular component
+		vec3 viewDirection = glm::normalize(pCam->GetCameraPosition() - position);
+		vec3 halfVector = glm::normalize(lightDirection + viewDirection);
+		float specular = std::pow(std::max(glm::dot(normal, halfVector), 0.0f), material.Shininess) * fShade;
+		Radiance specularResult = ToRadiance(material.Specular) * ToRadiance(currentLight.SpecularLight);
+		specularComponent = specularResult * specular;
+
+		// Return the final color
+		return ambientComponent + diffuseComponent + specularComponent;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+Radiance BlinnPhongLighting(PointLight& currentLight,
+	const Material& material,
+	const glm::vec3& position,
+	const glm::vec3& normal,
+	float fShade)
+{
+	Radiance ambientComponent, diffuseComponent(0.0f), specularComponent(0.0f);
+
+	// Ambient component
+	ambientComponent = ToRadiance(currentLight.AmbientLight) * ToRadiance(material.Ambient);
+
+	if (fShade == 0.0f)
+	{
+		// Return the final color
+		return ambientComponent;
+	}
+	else
+	{
+		// Diffuse component
+		glm::vec3 lightVector = currentLight.Position - position;
+		// Calculate the distance from the point light to the pixel position
+		float distance = glm::length(lightVector);
+		// Calculate the attenuation factor
+		//float attenuation = 1.0f / (currentLight.ConstantAttenuation +
+		//	currentLight.LinearAttenuation * distance +
+		//	currentLight.QuadraticAttenuation * (distance * distance));
+		glm::vec3 lightDirection = glm::normalize(lightVector);
+		float fNormalDotLight = glm::max(glm::dot(normal, lightDirection), 0.0f);
+		Radiance diffuseResult = ToRadiance(material.Diffuse) * ToRadiance(currentLight.DiffuseLight);
+		diffuseComponent = diffuseResult * fNormalDotLight * fShade;
+
+		// Specular component
+		vec3 viewDirection = glm::normalize(pCam->GetCameraPosition() - position);
+		vec3 halfVector = glm::normalize(lightDirection + viewDirection);
+		float specular = std::pow(std::max(glm::dot(normal, halfVector), 0.0f), material.Shininess) * fShade;
+		Radiance specularResult = ToRadiance(material.Specular) * ToRadiance(currentLight.SpecularLight);
+		specularComponent = specularResult * specular;
+
+		// Return the final color
+		return (ambientComponent + diffuseComponent + specularComponent);// *attenuation;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+Radiance BlinnPhongLighting(AreaLight& currentLight,
+	const Material& material,
+	const glm::vec3& position,
+	const glm::vec3& normal,
+	Scene& scene,
+	bool bSampleLight)
+{
+	// Ambient component
+	Radiance ambientComponent = ToRadiance(currentLight.AmbientLight) * ToRadiance(material.Ambient);
+
+	if (bSampleLight == false)
+	{
+		// Return the final color
+		return ambientComponent;
+	}
+	else
+	{
+		// Sum of the diffuse and specular factors of the visible samples. The
+		// light and material colors are the same for every sample.
+		float fDiffuseSum = 0.0f;
+		float fSpecularSum = 0.0f;
+
+		unsigned int sampleCountX = currentLight.GetSampleCountX();
+		unsigned int sampleCountZ = currentLight.GetSampleCountZ();
+
+		// Draw the light samples from this thread's generator
+		Sampler& sampler = GetThreadSampler();
+		sampler.StartSampleSet();
+
+		unsigned int uiFirstSample, uiSampleCount;
+		GetAreaLightSampleRange(currentLight, sampler, uiFirstSample, uiSampleCount);
+
+		vec3 viewDirection = glm::normalize(pCam->GetCameraPosition() - position);
+
+		RecordAreaLightShadowRays(currentLight, position);
+
+		for (unsigned int sample = 0; sample < uiSampleCount; sample++)
+		{
+			unsigned int uiSampleIndex = (uiFirstSample + sample) % (sampleCountX * sampleCountZ);
+
+			// Calculate the position of the next sample. The same point is
+			// used for the shadow test and for shading.
+			glm::vec3 currentSamplePoint = currentLight.GetSamplePoint(
+				sampler.SquareSample(uiSampleIndex, sampleCountX, sampleCountZ));
+
+			glm::vec3 lightDirection = glm::normalize(currentSamplePoint - position);
+
+			// Diffuse component
+			float fNormalDotLight = glm::max(glm::dot(normal, lightDirection), 0.0f);
+
+			// Specular component
+			vec3 halfVector = glm::normalize(lightDirection + viewDirection);
+			float specular = std::pow(std::max(glm::dot(normal, halfVector), 0.0f), material.Shininess);
+
+			// Samples which don't contribute don't need a shadow ray
+			if (fNormalDotLight == 0.0f && specular == 0.0f)
+			{
+				continue;
+			}
+
+			if (AreaLightSampleOccluded(scene, position, currentSamplePoint))
+			{
+				continue;
+			}
+
+			fDiffuseSum += fNormalDotLight;
+			fSpecularSum += specular;
+		}
+
+		Radiance diffuseResult = ToRadiance(material.Diffuse) * ToRadiance(currentLight.DiffuseLight);
+		Radiance specularResult = ToRadiance(material.Specular) * ToRadiance(currentLight.SpecularLight);
+
+		float fSampleScale = 1.0f / uiSampleCount;
+
+		// Return the final color
+		return ambientComponent + (diffuseResult * fDiffuseSum + specularResult * fSpecularSum) * fSampleScale;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+void CalculateSquareCoord(int intersectionX, int intersectionZ, int& coordX, int& coordZ)
+{
+	int xDivSq = intersectionX / SquareLength;
+	int xModSq = intersectionX % SquareLength;
+
+	int zDivSq = intersectionZ / SquareLength;
+	int zModSq = intersectionZ % SquareLength;
+
+	float extraX = (float)xModSq / SquareLength;
+	float extraZ = (float)zModSq / SquareLength;
+
+	coordX = xDivSq;
+	coordZ = zDivSq;
+
+	if (intersectionX < 0.0f)
+	{
+		// Left half
+		if (intersectionZ > 0.0f)
+		{
+			// Top left quadrant
+			if (extraX < 0.0f)
+			{
+				coordX--;
+			}
+		}
+		else
+		{
+			// Bottom left quadrant
+			if (extraX < 0.0f)
+			{
+				coordX--;
+			}
+			if (extraZ < 0.0f)
+			{
+				coordZ--;
+			}
+		}
+	}
+	else
+	{
+		// Right half
+		if (intersectionZ > 0.0f)
+		{
+			// Top right quadrant
+		}
+		else
+		{
+			// Bottom right quadrant
+			if (extraZ < 0.0f)
+			{
+				coordZ--;
+			}
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+// Shadow rays from a hit towards every directional and point light, passed
+// to visitor(shadowRay, tMax). Only occluders before tMax cast shadows.
+template <typename ShadowRayVisitor>
+void VisitShadowRays(const IntersectionInfo& intersect, Scene& scene, ShadowRayVisitor& visitor)
+{
+	std::vector<DirectionalLight*>& dirLightSources = scene.DirectionalLightList();
+
+	// Go through all directional light sources and calculate the shadow rays
+	for (unsigned int lightIndex = 0; lightIndex < dirLightSources.size(); lightIndex++)
+	{
+		// Get the current light source
+		DirectionalLight& currentLight = *dirLightSources[lightIndex];
+
+		glm::vec3 lightDirection = glm::normalize(currentLight.Direction);
+		glm::vec3 startPoint = intersect.IntersectionPoint + lightDirection * Constants::EPS;
+
+		visitor(Ray(startPoint, lightDirection), std::numeric_limits<float>::infinity());
+	}
+
+	std::vector<PointLight*>& pointLightSources = scene.PointLightList();
+
+	// Go through all the point lights in the scene
+	for (unsigned int lightIndex = 0; lightIndex < pointLightSources.size(); lightIndex++)
+	{
+		// Get the current light source
+		PointLight& currentLight = *pointLightSources[lightIndex];
+
+		glm::vec3 lightVector = currentLight.Position - intersect.IntersectionPoint;
+		float distance = glm::length(lightVector);
+		glm::vec3 lightDirection = glm::normalize(lightVector);
+		glm::vec3 startPoint = intersect.IntersectionPoint + lightDirection * Constants::EPS;
+
+		// Only occluders between the point and the light cast shadows
+		visitor(Ray(startPoint, lightDirection), distance);
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+// 0 if any directional or point light is blocked from the hit, 1 otherwise
+float HardShadowFactor(const IntersectionInfo& intersect, Scene& scene)
+{
+	float fShade = 1.0f;
+
+	TileDependencies* pDependencies = GetThreadTileDependencies();
+
+	auto testShadowRay = [&](const Ray& shadowRay, float tMax)
+	{
+		if (fShade == 0.0f)
+		{
+			return;
+		}
+
+		if (pDependencies != nullptr)
+		{
+			pDependencies->AddShadowRay(shadowRay, tMax);
+		}
+
+		// Light sources and the object itself don't cast shadows
+		if (scene.Occluded(shadowRay, tMax, intersect.HitObject))
+		{
+			fShade = 0.0f;
+		}
+	};
+
+	VisitShadowRays(intersect, scene, testShadowRay);
+
+	return fShade;
+}
+
+// -----------------------------------------------------------------------------
+
+// Color of a hit without its reflection and refraction, lit with the given
+// hard shadow factor. The reflected and refracted rays it spawns are
+// returned with the factor their color is added to the hit's color with.
+template <unsigned int Features>
+Radiance ShadeHit(const Ray& ray,
+	const IntersectionInfo& intersect,
+	Scene& scene,
+	float fShade,
+	unsigned int iReflectionDepth,
+	unsigned int iRefractionDepth,
+	float fRefractiveIndex,
+	SecondaryRay secondaryRays[2],
+	unsigned int& uiSecondaryCount)
+{
+	const bool bPlaneTexturing = (Features & keFEATURE_PLANE_TEXTURING) != 0;
+	const bool bReflection = (Features & keFEATURE_REFLECTION) != 0;
+	const bool bRefraction = (Features & keFEATURE_REFRACTION) != 0;
+
+	uiSecondaryCount = 0;
+
+	// --------------------------------------------------------------------
+	// Light source rendering
+
+	if (intersect.HitObject->IsLight())
+	{
+		return Radiance(1.0f);
+	}
+
+	// --------------------------------------------------------------------
+	// Get the material of the hit object
+
+	Material hitObjectMaterial = intersect.HitObject->GetMaterial();
+
+	// --------------------------------------------------------------------
+	// Procedural plane texturing
+
+	// Object type plane hit => square pattern texturing
+	if (bPlaneTexturing == true)
+	{
+		if (intersect.HitObject->Type() == ObjectType::kePLANE)
+		{
+			// Get the intersection point between the ray and the plane
+			int intersectionX = (int)floor(intersect.IntersectionPoint.x);
+			int intersectionZ = (int)floor(intersect.IntersectionPoint.z);
+
+			int xSquareCoordinate = 0;
+			int ySquareCoordinate = 0;
+
+			// Calculate the coordinates of the square where the intersection occurred
+			CalculateSquareCoord(intersectionX, intersectionZ, xSquareCoordinate, ySquareCoordinate);
+
+			if ((abs(xSquareCoordinate) + abs(ySquareCoordinate)) % 2 == 0)
+			{
+				hitObjectMaterial.Diffuse = sf::Color(0, 0, 0, 255);
+			}
+			else
+			{
+				hitObjectMaterial.Diffuse = sf::Color(255, 255, 255, 255);
+			}
+		}
+	}
+
+	// --------------------------------------------------------------------
+	// Shading model
+
+	// Calculate the color of the object based on the shading model
+	Radiance color = FindColor<Features>(intersect, hitObjectMaterial, scene, fShade);
+
+	// --------------------------------------------------------------------
+	// Refraction
+
+	// Calculate the direction of the refracted ray
+	glm::vec3 refractedDirection = glm::vec3(0.0f);
+	
+	// Reflection factor
+	float fReflectionFactor = 0.0f;
+
+	if (bRefraction == true)
+	{
+		glm::vec3 direction = glm::normalize(ray.GetDirection());
+		float cos_a1 = glm::dot(direction, intersect.NormalAtIntersection);
+		float sin_a1 = 0.0f;
+
+		if (cos_a1 <= -1.0f)
+		{
+			if (cos_a1 < -1.0001f)
+			{
+				std::cout << "Dot product too small." << std::endl;
+			}
+			cos_a1 = -1.0f;
+			sin_a1 = 0.0f;
+		}
+		else if (cos_a1 >= 1.0f)
+		{
+			if (cos_a1 > 1.0001f)
+			{
+				std::cout << "Dot product too large." << std::endl;
+			}
+			cos_a1 = 1.0f;
+			sin_a1 = 0.0f;
+		}
+		else
+		{
+			sin_a1 = sqrt(1.0f - cos_a1 * cos_a1);
+		}
+
+		// Calculate the ratio of the two refractive indices
+		const float ratio = fRefractiveIndex / hitObjectMaterial.RefractiveIndex;
+
+		// Use Snell's law to calculate the sine of the refracted ray and normal
+		const float sin_a2 = ratio * sin_a1;
+
+		if (sin_a2 <= -1.0f || sin_a2 >= 1.0f)
+		{
+			// There is no refraction, only reflection
+			fReflectionFactor = 1.0f;
+		}
+		else
+		{
+			// Solve quadratic for k
+			float x1, x2;
+
+			float a = 1.0f;
+			float b = 2.0f * cos_a1;
+			float c = 1.0f - 1.0f / (ratio * ratio);
+
+			float maxAlignment = -0.0001f;
+
+			if (SolveQuadratic(a, b, c, x1, x2) == true)
+			{
+				// Solution was found => find the correct one and exclude the ghost one
+
+				// ---------------------------------------------------------------------
+				// Calculate the direction of the refracted ray using the first solution
+
+				// Calculate the candidate for the refractive ray direction
+				glm::vec3 refractCandidate = direction + x1 * intersect.NormalAtIntersection;
+
+				// Calculate the angle between the incident and refracted ray
+				float alignment = glm::dot(direction, refractCandidate);
+				if (alignment > maxAlignment)
+				{
+					maxAlignment = alignment;
+					refractedDirection = refractCandidate;
+				}
+
+				// ---------------------------------------------------------------------
+				// Calculate the direction of the refracted ray using the second solution
+
+				refractCandidate = direction + x2 * intersect.NormalAtIntersection;
+				alignment = glm::dot(direction, refractCandidate);
+				if (alignment > maxAlignment)
+				{
+					maxAlignment = alignment;
+					refractedDirection = refractCandidate;
+				}
+
+				// ---------------------------------------------------------------------
+			}
+
+			if (maxAlignment <= 0.0f)
+			{
+				std::cout << "Invalid value for max alignment." << std::endl;
+			}
+
+			// Determine the cosine of the refracted ray and normal
+			float cos_a2 = sqrt(1.0f - sin_a2 * sin_a2);
+			if (cos_a1 < 0.0f)
+			{
+				// The polarity of cos_a1 must match the polarity of cos_a2
+				cos_a2 = -cos_a2;
+			}
+
+			// Determine the fraction of the light which is being reflected
+			float sPolarized = PolarizedReflection(fRefractiveIndex, hitObjectMaterial.RefractiveIndex, cos_a1, cos_a2);
+			float pPolarized = PolarizedReflection(fRefractiveIndex, hitObjectMaterial.RefractiveIndex, cos_a2, cos_a1);
+			fReflectionFactor = (sPolarized + pPolarized) * 0.5f;
+		}
+	}
+
+	// --------------------------------------------------------------------
+	// Reflection
+
+	// If the hit object is reflective and we haven't reached max reflection depth
+	if (bReflection == true && hitObjectMaterial.Reflectivity > 0 && iReflectionDepth < MAX_REFLECTION_DEPTH)
+	{
+		// Calculate the reflected ray
+		vec3 reflectionDirection = glm::normalize(glm::reflect<vec3>(ray.GetDirection(), intersect.NormalAtIntersection));
+
+		glm::vec3 startPoint = intersect.IntersectionPoint + reflectionDirection * Constants::EPS;
+
+		SecondaryRay& reflection = secondaryRays[uiSecondaryCount++];
+		reflection.TracedRay = Ray(startPoint, reflectionDirection);
+
+		// With refraction the reflected part is given by Fresnel, otherwise
+		// by the object's material reflectiveness
+		reflection.Weight = bRefraction ? hitObjectMaterial.Reflectivity * fReflectionFactor : hitObjectMaterial.Reflectivity;
+	}
+
+	// --------------------------------------------------------------------
+	// Refraction
+
+	if (bRefraction == true && hitObjectMaterial.Transparency > 0 && iRefractionDepth < MAX_REFRACTION_DEPTH)
+	{
+		// Calculate the refracted ray
+		refractedDirection = glm::normalize(refractedDirection);
+
+		glm::vec3 startPoint = intersect.IntersectionPoint + refractedDirection * Constants::EPS;
+
+		SecondaryRay& refraction = secondaryRays[uiSecondaryCount++];
+		refraction.TracedRay = Ray(startPoint, refractedDirection);
+		refraction.Weight = hitObjectMaterial.Transparency * (1.0f - fReflectionFactor);
+	}
+
+	// --------------------------------------------------------------------
+
+	return color;
+}
+
+// -----------------------------------------------------------------------------
+
+// Whether a branch of the ray tree whose path weight is fWeight gets traced.
+// Branches below ContributionThreshold are dropped. With Russian roulette
+// they survive with a probability proportional to their weight instead and
+// are weighted up, so the average stays the same.
+inline bool KeepBranch(float& fWeight, Sampler& sampler)
+{
+	if (fWeight >= ContributionThreshold)
+	{
+		return true;
+	}
+
+	if (RussianRouletteEnabled == false || fWeight <= 0.0f)
+	{
+		return false;
+	}
+
+	if (sampler.NextFloat() * ContributionThreshold >= fWeight)
+	{
+		return false;
+	}
+
+	fWeight = ContributionThreshold;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// Color seen along the ray given its closest intersection. The reflected and
+// refracted rays are traced depth first from an explicit stack, each adding
+// its color scaled by its path weight.
+template <unsigned int Features>
+void Shade(const Ray& ray, 
+	const IntersectionInfo& intersect,
+	Radiance& colorAccumulator, 
+	Scene& scene, 
+	unsigned int iReflectionDepth,
+	unsigned int iRefractionDepth,
+	float fRefractiveIndex)
+{
+	const bool bShadows = (Features & keFEATURE_SHADOWS) != 0;
+
+	Sampler& sampler = GetThreadSampler();
+
+	std::vector<PendingRay>& pendingRays = GetThreadPendingRays();
+	pendingRays.clear();
+
+	PendingRay current = { ray, 1.0f, iReflectionDepth, iRefractionDepth };
+	IntersectionInfo hit = intersect;
+
+	while (true)
+	{
+		if (hit.HitObject != NULL)
+		{
+			float fShade = 1.0f;
+			if (bShadows == true && hit.HitObject->IsLight() == false)
+			{
+				fShade = HardShadowFactor(hit, scene);
+			}
+
+			SecondaryRay secondaryRays[2];
+			unsigned int uiSecondaryCount;
+
+			Radiance color = ShadeHit<Features>(current.TracedRay,
+				hit,
+				scene,
+				fShade,
+				current.ReflectionDepth,
+				current.RefractionDepth,
+				fRefractiveIndex,
+				secondaryRays,
+				uiSecondaryCount);
+
+			colorAccumulator += color * current.Weight;
+
+			// Pushed in reverse so the reflected ray is traced before the
+			// refracted one
+			for (unsigned int index = uiSecondaryCount; index-- > 0;)
+			{
+				float fBranchWeight = current.Weight * secondaryRays[index].Weight;
+				if (KeepBranch(fBranchWeight, sampler))
+				{
+					pendingRays.push_back({ secondaryRays[index].TracedRay,
+						fBranchWeight,
+						current.ReflectionDepth + 1,
+						current.RefractionDepth + 1 });
+				}
+			}
+		}
+
+		if (pendingRays.empty())
+		{
+			break;
+		}
+
+		current = pendingRays.back();
+		pendingRays.pop_back();
+
+		// Bounces always start in the surrounding medium
+		fRefractiveIndex = AmbientRefractiveIndex;
+		hit = RaySceneIntersection(current.TracedRay, scene);
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+template <unsigned int Features>
+void Trace(const Ray& ray, 
+	Radiance& colorAccumulator, 
+	Scene& scene, 
+	unsigned int iReflectionDepth,
+	unsigned int iRefractionDepth,
+	float fRefractiveIndex)
+{
+	// Calculate intersection
+	IntersectionInfo intersect = RaySceneIntersection(ray, scene);
+
+	Shade<Features>(ray, intersect, colorAccumulator, scene, iReflectionDepth, iRefractionDepth, fRefractiveIndex);
+}
+
+// -----------------------------------------------------------------------------
+
+// Trace the rays of the queue breadth first, one bounce generation at a time.
+// Every generation of bounces is sorted by origin cell and direction before
+// its rays are intersected in bulk, then its shadow rays are sorted and tested in bulk
+// and the hits are shaded, which queues the next generation. The colors are
+// added to queues.Colors. With bPrimaryHitsFound the hits of the queued rays
+// are already in queues.Hits.
+template <unsigned int Features>
+void TraceWavefront(WavefrontQueues& queues, bool bPrimaryHitsFound, Scene& scene)
+{
+	const bool bShadows = (Features & keFEATURE_SHADOWS) != 0;
+
+	Sampler& sampler = GetThreadSampler();
+
+	const RayStreamOrder order(scene.GetBounds());
+
+	bool bHitsFound = bPrimaryHitsFound;
+	bool bFirstGeneration = true;
+
+	while (queues.Rays.Empty() == false)
+	{
+		RayQueue<QueuedRay>& rays = queues.Rays;
+		const unsigned int uiRayCount = rays.Size();
+
+		// The primary rays come in packet order, which is coherent already
+		if (bFirstGeneration == true)
+		{
+			rays.KeepOrder();
+		}
+		else
+		{
+			rays.Sort(order);
+		}
+
+		// --------------------------------------------------------------------
+		// Closest hits
+
+		if (bHitsFound == false)
+		{
+			queues.Hits.resize(uiRayCount);
+
+			for (unsigned int uiPosition = 0; uiPosition < uiRayCount; uiPosition++)
+			{
+				unsigned int index = rays.Sorted(uiPosition);
+				queues.Hits[index] = RaySceneIntersection(rays[index].TracedRay, scene);
+			}
+		}
+		bHitsFound = false;
+
+		// --------------------------------------------------------------------
+		// Shadows
+
+		queues.Shade.assign(uiRayCount, 1.0f);
+
+		if (bShadows == true)
+		{
+			queues.ShadowRays.Clear();
+
+			for (unsigned int index = 0; index < uiRayCount; index++)
+			{
+				const IntersectionInfo& hit = queues.Hits[index];
+				if (hit.HitObject == NULL || hit.HitObject->IsLight())
+				{
+					continue;
+				}
+
+				auto queueShadowRay = [&](const Ray& shadowRay, float tMax)
+				{
+					queues.ShadowRays.Push({ shadowRay, tMax, index });
+				};
+
+				VisitShadowRays(hit, scene, queueShadowRay);
+			}
+
+			queues.ShadowRays.Sort(order);
+
+			TileDependencies* pDependencies = GetThreadTileDependencies();
+
+			for (unsigned int uiPosition = 0; uiPosition < queues.ShadowRays.Size(); uiPosition++)
+			{
+				const QueuedShadowRay& shadowRay = queues.ShadowRays[queues.ShadowRays.Sorted(uiPosition)];
+
+				if (queues.Shade[shadowRay.Hit] == 0.0f)
+				{
+					continue;
+				}
+
+				if (pDependencies != nullptr)
+				{
+					pDependencies->AddShadowRay(shadowRay.TracedRay, shadowRay.MaxDistance);
+				}
+
+				// Light sources and the object itself don't cast shadows
+				if (scene.Occluded(shadowRay.TracedRay, shadowRay.MaxDistance, queues.Hits[shadowRay.Hit].HitObject))
+				{
+					queues.Shade[shadowRay.Hit] = 0.0f;
+				}
+			}
+		}
+
+		// --------------------------------------------------------------------
+		// Shading, which spawns the next generation
+
+		queues.NextRays.Clear();
+
+		for (unsigned int uiPosition = 0; uiPosition < uiRayCount; uiPosition++)
+		{
+			unsigned int index = rays.Sorted(uiPosition);
+
+			const QueuedRay& queuedRay = rays[index];
+			const IntersectionInfo& hit = queues.Hits[index];
+
+			if (hit.HitObject == NULL)
+			{
+				continue;
+			}
+
+			sampler = queuedRay.PathSampler;
+
+			SecondaryRay secondaryRays[2];
+			unsigned int uiSecondaryCount;
+
+			Radiance color = ShadeHit<Features>(queuedRay.TracedRay,
+				hit,
+				scene,
+				queues.Shade[index],
+				queuedRay.ReflectionDepth,
+				queuedRay.RefractionDepth,
+				AmbientRefractiveIndex,
+				secondaryRays,
+				uiSecondaryCount);
+
+			queues.Colors[queuedRay.Slot] += color * queuedRay.Weight;
+
+			for (unsigned int uiSecondary = 0; uiSecondary < uiSecondaryCount; uiSecondary++)
+			{
+				float fBranchWeight = queuedRay.Weight * secondaryRays[uiSecondary].Weight;
+				if (KeepBranch(fBranchWeight, sampler) == false)
+				{
+					continue;
+				}
+
+				QueuedRay nextRay;
+				nextRay.TracedRay = secondaryRays[uiSecondary].TracedRay;
+				nextRay.PathSampler = sampler.Split();
+				nextRay.Weight = fBranchWeight;
+				nextRay.Slot = queuedRay.Slot;
+				nextRay.ReflectionDepth = queuedRay.ReflectionDepth + 1;
+				nextRay.RefractionDepth = queuedRay.RefractionDepth + 1;
+
+				queues.NextRays.Push(nextRay);
+			}
+		}
+
+		rays.Swap(queues.NextRays);
+		bFirstGeneration = false;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+template <unsigned int Features>
+Radiance FindColor(const IntersectionInfo& intersect, 
+	const Material& hitObjectMaterial,
+	Scene& scene,
+	float fShade)
+{
+	const bool bSoftShadows = (Features & keFEATURE_SOFT_SHADOWS) != 0;
+	const bool bBlinnPhong = (Features & keFEATURE_BLINN_PHONG) != 0;
+
+	// ---------------------------------------------------------------------------
+
+	Radiance finalColor = Radiance(0.0f);
+
+	// ---------------------------------------------------------------------------
+
+	std::vector<DirectionalLight*>& dirLightSources = scene.DirectionalLightList();
+	std::vector<PointLight*>& pointLightSources = scene.PointLightList();
+	std::vector<AreaLight*>& areaLightSources = scene.AreaLightList();
+
+	// ---------------------------------------------------------------------------
+
+	// Go through all the area lights in the scene. They are only sampled with
+	// soft shadows enabled, each sample is then shadow tested and shaded with
+	// the same point on the light.
+	for (unsigned int lightIndex = 0; lightIndex < areaLightSources.size(); lightIndex++)
+	{
+		AreaLight& currentAreaLight = *areaLightSources[lightIndex];
+
+		if (bBlinnPhong == false)
+		{
+			// Compute the final color
+			finalColor += PhongLighting(currentAreaLight,
+				hitObjectMaterial,
+				intersect.IntersectionPoint,
+				intersect.NormalAtIntersection,
+				scene,
+				bSoftShadows);
+		}
+		else
+		{
+			// Compute the final color
+			finalColor += BlinnPhongLighting(currentAreaLight,
+				hitObjectMaterial,
+				intersect.IntersectionPoint,
+				intersect.NormalAtIntersection,
+				scene,
+				bSoftShadows);
+		}
+	}
+
+	// ---------------------------------------------------------------------------
+	
+	// Go through all directional light sources in the scene
+	for (unsigned int lightIndex = 0; lightIndex < dirLightSources.size(); lightIndex++)
+	{
+		// Get the current light source
+		DirectionalLight& currentLight = *dirLightSources[lightIndex];
+
+		if (bBlinnPhong == false)
+		{
+			// Compute the final color
+			finalColor += PhongLighting(currentLight,
+				hitObjectMaterial,
+				intersect.IntersectionPoint,
+				intersect.NormalAtIntersection,
+				fShade);
+		}
+		else
+		{
+			// Compute the final color
+			finalColor += BlinnPhongLighting(currentLight,
+				hitObjectMaterial,
+				intersect.IntersectionPoint,
+				intersect.NormalAtIntersection,
+				fShade);
+		}
+	}
+
+	// ---------------------------------------------------------------------------
+
+	// Go through all the point lights in the scene
+	for (unsigned int lightIndex = 0; lightIndex < pointLightSources.size(); lightIndex++)
+	{
+		// Get the current light source
+		PointLight& currentLight = *pointLightSources[lightIndex];
+
+		if (bBlinnPhong == false)
+		{
+			// Compute the final color
+			finalColor += PhongLighting(currentLight,
+				hitObjectMaterial,
+				intersect.IntersectionPoint,
+				intersect.NormalAtIntersection,
+				fShade);
+		}
+		else
+		{
+			// Compute the final color
+			finalColor += BlinnPhongLighting(currentLight,
+				hitObjectMaterial,
+				intersect.IntersectionPoint,
+				intersect.NormalAtIntersection,
+				fShade);
+		}
+	}
+
+	// ---------------------------------------------------------------------------
+
+	return finalColor;
+}
+
+// -----------------------------------------------------------------------------
+
+IntersectionInfo RaySceneIntersection(const Ray& ray, Scene& scene)
+{
+	// Planes are tested directly, everything else goes through the scene's BVH
+	IntersectionInfo intersect = scene.FindIntersection(ray);
+
+	TileDependencies* pDependencies = GetThreadTileDependencies();
+	if (pDependencies != nullptr)
+	{
+		pDependencies->AddRay(ray, intersect);
+	}
+
+	return intersect;
+}
+
+// ------------------------------------------------------------------------
+
+template <unsigned int... Features>
+std::array<TraceFunction, sizeof...(Features)> MakeTraceTable(std::integer_sequence<unsigned int, Features...>)
+{
+	return {{ &Trace<Features>... }};
+}
+
+template <unsigned int... Features>
+std::array<ShadeFunction, sizeof...(Features)> MakeShadeTable(std::integer_sequence<unsigned int, Features...>)
+{
+	return {{ &Shade<Features>... }};
+}
+
+template <unsigned int... Features>
+std::array<WavefrontFunction, sizeof...(Features)> MakeWavefrontTable(std::integer_sequence<unsigned int, Features...>)
+{
+	return {{ &TraceWavefront<Features>... }};
+}
+
+// One Trace, Shade and TraceWavefront instantiation per feature combination,
+// indexed by the flags
+const std::array<TraceFunction, keFEATURE_COMBINATION_COUNT> traceTable =
+	MakeTraceTable(std::make_integer_sequence<unsigned int, keFEATURE_COMBINATION_COUNT>());
+const std::array<ShadeFunction, keFEATURE_COMBINATION_COUNT> shadeTable =
+	MakeShadeTable(std::make_integer_sequence<unsigned int, keFEATURE_COMBINATION_COUNT>());
+const std::array<WavefrontFunction, keFEATURE_COMBINATION_COUNT> wavefrontTable =
+	MakeWavefrontTable(std::make_integer_sequence<unsigned int, keFEATURE_COMBINATION_COUNT>());
+
+// Feature flags of the current settings
+unsigned int CurrentRenderFeatures()
+{
+	unsigned int uiFeatures = 0;
+
+	if (PlaneTexturingEnabled == true) { uiFeatures |= keFEATURE_PLANE_TEXTURING; }
+	if (ShadowsEnabled == true) { uiFeatures |= keFEATURE_SHADOWS; }
+	if (SoftShadowsEnabled == true) { uiFeatures |= keFEATURE_SOFT_SHADOWS; }
+	if (ReflectionEnabled == true) { uiFeatures |= keFEATURE_REFLECTION; }
+	if (RefractionEnabled == true) { uiFeatures |= keFEATURE_REFRACTION; }
+	if (eLightModel == LightingModel::BlinnPhong) { uiFeatures |= keFEATURE_BLINN_PHONG; }
+
+	return uiFeatures;
+}
+
+// ------------------------------------------------------------------------
+
+void DrawTile(const Tile& tile)
+{
+	unsigned int uiTile = GetTileIndex(tile);
+
+	// Tiles the moved objects can't have changed keep their pixels
+	if (bPartialFrame == true && dirtyTiles[uiTile] == false)
+	{
+		return;
+	}
+
+	TileDependencies*& pDependencies = GetThreadTileDependencies();
+	pDependencies = nullptr;
+
+	if (bRecordDependencies == true)
+	{
+		pDependencies = &tileDependencies[uiTile];
+		pDependencies->Clear();
+	}
+
+	Draw(tile);
+
+	// The pixels of an adaptive frame are final once they are refined
+	if (bAdaptiveFrame == false)
+	{
+		Tonemap(tile);
+	}
+
+	pDependencies = nullptr;
+}
+
+// ------------------------------------------------------------------------
+
+void Render(const Tile& tile)
+{
+	if (Realtime == true)
+	{
+		DrawTile(tile);
+	}
+	else
+	{
+		if (UpdateRequired == true)
+		{
+			DrawTile(tile);
+		}
+	}
+}
+
+// ------------------------------------------------------------------------
+
+void Tonemap(const Tile& tile)
+{
+	// Every row of the tile is a contiguous run in both buffers. The radiance
+	// is scaled by 255 over the sample weight, saturated to [0, 255] and
+	// rounded half up. Both paths do the same float operations, so they give
+	// the same bytes.
+	for (unsigned int uiRow = tile.StartY; uiRow < tile.EndY; uiRow++)
+	{
+		unsigned int uiRowStart = uiRow * iWidth;
+
+		const float* pSource = &accumulation[uiRowStart + tile.StartX].x;
+		sf::Uint8* pDestination = pixels + 4 * (uiRowStart + tile.StartX);
+		unsigned int uiCount = tile.EndX - tile.StartX;
+
+#ifdef TONEMAP_SSE2
+
+		const __m128 minWeight = _mm_set1_ps(1e-6f);
+		const __m128 minValue = _mm_setzero_ps();
+		const __m128 maxValue = _mm_set1_ps(255.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		for (unsigned int index = 0; index < uiCount; index++)
+		{
+			// R, G, B and the weight of one pixel
+			__m128 value = _mm_loadu_ps(pSource + 4 * index);
+			__m128 weight = _mm_max_ps(_mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 3, 3)), minWeight);
+
+			__m128 scale = _mm_div_ps(maxValue, weight);
+			__m128 scaled = _mm_min_ps(_mm_max_ps(_mm_mul_ps(value, scale), minValue), maxValue);
+
+			// Round half up by truncation, then pack to 8 bits
+			__m128i packed = _mm_cvttps_epi32(_mm_add_ps(scaled, half));
+			packed = _mm_packs_epi32(packed, packed);
+			packed = _mm_packus_epi16(packed, packed);
+
+			// The output is always opaque
+			int iPixel = _mm_cvtsi128_si32(packed) | (int)0xFF000000;
+			memcpy(pDestination + 4 * index, &iPixel, 4);
+		}
+
+#else
+
+		for (unsigned int index = 0; index < uiCount; index++)
+		{
+			const float* pValue = pSource + 4 * index;
+			float fScale = 255.0f / glm::max(pValue[3], 1e-6f);
+
+			for (unsigned int channel = 0; channel < 3; channel++)
+			{
+				float fValue = glm::clamp(pValue[channel] * fScale, 0.0f, 255.0f);
+				pDestination[4 * index + channel] = (sf::Uint8)(fValue + 0.5f);
+			}
+			pDestination[4 * index + 3] = 255;
+		}
+
+#endif // TONEMAP_SSE2
+	}
+}
+
+// ------------------------------------------------------------------------
+
+// Surfaces whose color depends on the direction they are seen from
+inline bool IsViewDependent(Object* pObject)
+{
+	if (pObject->IsLight())
+	{
+		return false;
+	}
+
+	const Material& material = pObject->GetMaterial();
+
+	return material.Specular.r != 0 || material.Specular.g != 0 || material.Specular.b != 0 ||
+		(ReflectionEnabled == true && material.Reflectivity > 0.0f) ||
+		(RefractionEnabled == true && material.Transparency > 0.0f);
+}
+
+// ------------------------------------------------------------------------
+
+// Give the pixel the color of the last frame's pixel the hit is seen in, if
+// that one saw the same point. Returns false if the pixel has to be shaded.
+bool ReprojectSample(const IntersectionInfo& hit,
+	int iPixel,
+	const CameraFrame& historyFrame,
+	float fMinViewCosine,
+	float fPixelAngle)
+{
+	if (hit.HitObject == NULL)
+	{
+		return false;
+	}
+
+	glm::vec2 pixel;
+	if (historyFrame.Project(hit.IntersectionPoint, pixel) == false)
+	{
+		return false;
+	}
+
+	// The primary rays go through the integer positions
+	int iColumn = (int)std::floor(pixel.x + 0.5f);
+	int iRow = (int)std::floor(pixel.y + 0.5f);
+	if (iColumn < 0 || iRow < 0 || iColumn >= (int)iWidth || iRow >= (int)iHeight)
+	{
+		return false;
+	}
+
+	int iHistoryPixel = iColumn + iRow * iWidth;
+	const IntersectionInfo& historyHit = historyHits[iHistoryPixel];
+
+	// Disoccluded: the last frame saw something else there
+	float fDistance = glm::length(hit.IntersectionPoint - historyFrame.Position);
+	if (historyHit.HitObject != hit.HitObject ||
+		glm::abs(fDistance - historyHit.RayLength) > fReprojectionDepthTolerance * historyHit.RayLength ||
+		glm::dot(historyHit.NormalAtIntersection, hit.NormalAtIntersection) < fReprojectionMinNormalCosine)
+	{
+		return false;
+	}
+
+	const ShadingOrigin& origin = historyShadingOrigins[iHistoryPixel];
+
+	// The footprint of a pixel grows with the distance
+	glm::vec3 toCamera = pCam->GetCameraPosition() - hit.IntersectionPoint;
+	float fMaxDrift = fReprojectionMaxDrift * fPixelAngle * glm::length(toCamera);
+	if (glm::length(hit.IntersectionPoint - origin.SurfacePoint) > fMaxDrift)
+	{
+		return false;
+	}
+
+	if (IsViewDependent(hit.HitObject))
+	{
+		glm::vec3 shadingDirection = glm::normalize(origin.CameraPosition - hit.IntersectionPoint);
+		glm::vec3 viewDirection = glm::normalize(toCamera);
+
+		if (glm::dot(shadingDirection, viewDirection) < fMinViewCosine)
+		{
+			return false;
+		}
+	}
+
+	accumulation[iPixel] = historyColors[iHistoryPixel];
+	shadingOrigins[iPixel] = origin;
+	return true;
+}
+
+// ------------------------------------------------------------------------
+
+void Draw(const Tile& tile)
+{
+	// ------------------------------------------------------------------------
+	// Pre-compute camera values
+	float fTanHalfHorizFOV = glm::tan(rad(pCam->GetHorizontalFOV() / 2.0f));
+	float fTanHalfVertFOV = glm::tan(rad(pCam->GetVerticalFOV() / 2.0f));
+
+	float fHalfWidth = iWidth * 0.5f;
+	float fHalfHeight = iHeight * 0.5f;
+
+	// ------------------------------------------------------------------------
+	// Build a coordinate frame
+	vec3 vEyeTarget = pCam->GetCameraPosition() - pCam->GetCameraTarget();
+
+	vec3 w = glm::normalize(vEyeTarget);
+	vec3 u = glm::normalize(glm::cross(pCam->GetCameraUp(), w));
+	vec3 v = glm::normalize(glm::cross(w, u));
+
+	// ------------------------------------------------------------------------
+
+	// Primary ray through the point (fX, fY) of the image, in pixels
+	auto primaryRay = [&](float fX, float fY)
+	{
+		float fNormalizedXPos = ((fHalfWidth - fX) / fHalfWidth);
+		float fNormalizedYPos = ((fHalfHeight - fY) / fHalfHeight);
+
+		float fAlpha = fTanHalfHorizFOV * fNormalizedXPos;
+		float fBeta = fTanHalfVertFOV * fNormalizedYPos;
+
+		glm::vec3 rayDirection = glm::normalize(fAlpha * u + fBeta * v - w);
+
+		return Ray(pCam->GetCameraPosition(), rayDirection);
+	};
+
+	// Progressive frames add the sample to the running average, the first
+	// sample replaces whatever the buffer held before
+	auto storeSample = [&](int iPixel, const Radiance& color)
+	{
+		glm::vec4 newSample = glm::vec4(color, 1.0f);
+		if (bProgressiveFrame == true && uiProgressiveSampleCount > 0)
+		{
+			accumulation[iPixel] += newSample;
+		}
+		else
+		{
+			accumulation[iPixel] = newSample;
+		}
+
+		if (eGBufferUse != keGBUFFER_UNUSED)
+		{
+			shadingOrigins[iPixel].CameraPosition = pCam->GetCameraPosition();
+			shadingOrigins[iPixel].SurfacePoint = gBuffer[iPixel].IntersectionPoint;
+		}
+	};
+
+	int iCurrentPixel;
+
+	Sampler& sampler = GetThreadSampler();
+	sampler.SetPattern(eSamplePattern);
+
+	// One sample per pixel ----------------------------------------------------------
+	// The primary rays of a block of pixels go through the scene together as
+	// a packet. The pixels are then shaded one by one with single rays for the
+	// shadows and the bounces, or in wavefront mode all the rays of the tile
+	// are traced together one bounce generation at a time.
+
+	const bool bPackets = PacketTracingEnabled;
+	const bool bWavefront = WavefrontEnabled;
+
+	if ((bPackets == true || bWavefront == true || eGBufferUse != keGBUFFER_UNUSED) &&
+		(bProgressiveFrame == true || bAdaptiveFrame == true || SuperSamplingEnabled == false || SampleCount <= 1.0f))
+	{
+		// Without packets or the G-buffer the wavefront finds the primary
+		// hits itself, in the same pass as the bounces
+		const bool bHitsFound = (bPackets == true || bWavefront == false || eGBufferUse != keGBUFFER_UNUSED);
+
+		RayPacket packet;
+		IntersectionInfo primaryHits[RayPacket::MAX_SIZE];
+
+		// Sampler state of every pixel after its ray was made, restored for
+		// the shading so the samples don't depend on packets being used
+		Sampler pixelSamplers[RayPacket::MAX_SIZE];
+		int pixelIndices[RayPacket::MAX_SIZE];
+
+		WavefrontQueues& queues = GetThreadWavefrontQueues();
+		if (bWavefront == true)
+		{
+			queues.Rays.Clear();
+			queues.Hits.clear();
+			queues.Pixels.clear();
+		}
+
+		// Pixels which still see what they saw in the last frame keep their
+		// color, the others are shaded
+		const CameraFrame historyFrame(historyCamera);
+		const float fMinViewCosine = glm::cos(rad(fReprojectionMaxViewAngle));
+		const float fPixelAngle = 2.0f * fTanHalfHorizFOV / iWidth;
+
+		bool reprojected[RayPacket::MAX_SIZE];
+		unsigned int uiReprojectedCount = 0;
+
+		for (unsigned int uiBlockY = tile.StartY; uiBlockY < tile.EndY; uiBlockY += iPacketBlockSize)
+		{
+			for (unsigned int uiBlockX = tile.StartX; uiBlockX < tile.EndX; uiBlockX += iPacketBlockSize)
+			{
+				int iBlockEndX = (int)glm::min(uiBlockX + iPacketBlockSize, tile.EndX);
+				int iBlockEndY = (int)glm::min(uiBlockY + iPacketBlockSize, tile.EndY);
+
+				packet.Reset(pCam->GetCameraPosition());
+
+				for (int iRow = (int)uiBlockY; iRow < iBlockEndY; iRow++)
+				{
+					for (int iColumn = (int)uiBlockX; iColumn < iBlockEndX; iColumn++)
+					{
+						sampler.StartPixel(iColumn, iRow, uiFrameIndex, RandomSeed);
+
+						float fSampleX = (float)iColumn;
+						float fSampleY = (float)iRow;
+						if (bProgressiveFrame == true)
+						{
+							// Random position in the pixel
+							fSampleX = iColumn + sampler.NextFloat();
+							fSampleY = iRow + sampler.NextFloat();
+						}
+
+						pixelSamplers[packet.Count] = sampler;
+						pixelIndices[packet.Count] = iColumn + iRow * iWidth;
+
+						packet.Add(primaryRay(fSampleX, fSampleY));
+					}
+				}
+
+				if (eGBufferUse == keGBUFFER_REUSE)
+				{
+					// Same camera and geometry as when the hits were kept, the
+					// rays are the same too
+					for (unsigned int index = 0; index < packet.Count; index++)
+					{
+						primaryHits[index] = gBuffer[pixelIndices[index]];
+					}
+				}
+				else if (bPackets == true)
+				{
+					packet.Finalize();
+					scene.FindIntersectionPacket(packet, primaryHits);
+				}
+				else if (bHitsFound == true)
+				{
+					for (unsigned int index = 0; index < packet.Count; index++)
+					{
+						primaryHits[index] = RaySceneIntersection(packet.Rays[index], scene);
+					}
+				}
+
+				if (eGBufferUse == keGBUFFER_STORE)
+				{
+					for (unsigned int index = 0; index < packet.Count; index++)
+					{
+						gBuffer[pixelIndices[index]] = primaryHits[index];
+					}
+				}
+
+				// The rays of the packet aren't recorded, the projection of
+				// the moved objects stands for them
+				TileDependencies* pDependencies = GetThreadTileDependencies();
+				if (pDependencies != nullptr && bHitsFound == true)
+				{
+					for (unsigned int index = 0; index < packet.Count; index++)
+					{
+						pDependencies->AddHit(primaryHits[index].HitObject);
+					}
+				}
+
+				for (unsigned int index = 0; index < packet.Count; index++)
+				{
+					reprojected[index] = (bReprojectFrame == true &&
+						ReprojectSample(primaryHits[index], pixelIndices[index], historyFrame, fMinViewCosine, fPixelAngle));
+
+					uiReprojectedCount += reprojected[index] ? 1 : 0;
+				}
+
+				if (bWavefront == true)
+				{
+					// First generation of the tile's wavefront
+					for (unsigned int index = 0; index < packet.Count; index++)
+					{
+						if (reprojected[index] == true)
+						{
+							continue;
+						}
+
+						QueuedRay queuedRay;
+						queuedRay.TracedRay = packet.Rays[index];
+						queuedRay.PathSampler = pixelSamplers[index];
+						queuedRay.Weight = 1.0f;
+						queuedRay.Slot = (unsigned int)queues.Pixels.size();
+						queuedRay.ReflectionDepth = 0;
+						queuedRay.RefractionDepth = 0;
+
+						queues.Rays.Push(queuedRay);
+						queues.Pixels.push_back(pixelIndices[index]);
+
+						if (bHitsFound == true)
+						{
+							queues.Hits.push_back(primaryHits[index]);
+						}
+					}
+					continue;
+				}
+
+				for (unsigned int index = 0; index < packet.Count; index++)
+				{
+					if (reprojected[index] == true)
+					{
+						continue;
+					}
+
+					sampler = pixelSamplers[index];
+
+					Radiance surfaceColor = Radiance(0.0f);
+					pShadeFunction(packet.Rays[index], primaryHits[index], surfaceColor, scene, 0, 0, AmbientRefractiveIndex);
+
+					storeSample(pixelIndices[index], surfaceColor);
+				}
+			}
+		}
+
+		if (bWavefront == true)
+		{
+			queues.Colors.assign(queues.Pixels.size(), Radiance(0.0f));
+
+			pWavefrontFunction(queues, bHitsFound, scene);
+
+			for (size_t uiSlot = 0; uiSlot < queues.Pixels.size(); uiSlot++)
+			{
+				storeSample(queues.Pixels[uiSlot], queues.Colors[uiSlot]);
+			}
+		}
+
+		uiReprojectedPixelCount += uiReprojectedCount;
+
+		return;
+	}
+
+	// Update pixels
+	for (int iRow = (int)tile.StartY; iRow < (int)tile.EndY; iRow++)
+	{
+		for (int iColumn = (int)tile.StartX; iColumn < (int)tile.EndX; iColumn++)
+		{
+			// The samples only depend on the pixel, not on the worker
+			sampler.StartPixel(iColumn, iRow, uiFrameIndex, RandomSeed);
+
+			iCurrentPixel = iColumn + iRow * iWidth;
+
+			// Progressive ---------------------------------------------------------------
+			if (bProgressiveFrame == true)
+			{
+				// One sample at a random position in the pixel. The average over
+				// the frames converges to the super sampled image.
+				float fSampleX = iColumn + sampler.NextFloat();
+				float fSampleY = iRow + sampler.NextFloat();
+
+				Ray camIJRay = primaryRay(fSampleX, fSampleY);
+
+				Radiance surfaceColor = Radiance(0.0f);
+				pTraceFunction(camIJRay, surfaceColor, scene, 0, 0, AmbientRefractiveIndex);
+
+				storeSample(iCurrentPixel, surfaceColor);
+			}
+			// Anti-aliasing active ---------------------------------------------------------
+			else if (bAdaptiveFrame == false && SuperSamplingEnabled == true && SampleCount > 1.0f)
+			{
+				Radiance colorSum = Radiance(0.0f);
+
+				// SampleCount x SampleCount samples in the middle of the cells
+				// of a grid over the pixel, which is centered on the position
+				// of the single sample
+				float startX = (float)iColumn - 0.5f + 0.5f * SampleDistance;
+				float startY = (float)iRow - 0.5f + 0.5f * SampleDistance;
+
+				for (int iSampleY = 0; iSampleY < SampleCount; iSampleY++)
+				{
+					for (int iSampleX = 0; iSampleX < SampleCount; iSampleX++)
+					{
+						// -------------------------------------------------------------------
+
+						Ray camIJRay = primaryRay(startX + iSampleX * SampleDistance, startY + iSampleY * SampleDistance);
+
+						Radiance surfaceColor = Radiance(0.0f);
+						pTraceFunction(camIJRay, surfaceColor, scene, 0, 0, AmbientRefractiveIndex);
+
+						colorSum += surfaceColor;
+
+						// -------------------------------------------------------------------
+					}
+				}
+
+				// Store the average of the samples
+				accumulation[iCurrentPixel] = glm::vec4(colorSum / (float)(SampleCount * SampleCount), 1.0f);
+			}
+			else // No anti-aliasing ---------------------------------------------------------
+			{
+				Ray camIJRay = primaryRay((float)iColumn, (float)iRow);
+
+				Radiance surfaceColor = Radiance(0.0f);
+				pTraceFunction(camIJRay, surfaceColor, scene, 0, 0, AmbientRefractiveIndex);
+
+				storeSample(iCurrentPixel, surfaceColor);
+			}
+		}
+	}
+}
+
+// ------------------------------------------------------------------------
+
+// Both colors clamped to the displayed range, like the tonemap pass does
+inline bool HighContrast(const Radiance& first, const Radiance& second)
+{
+	Radiance difference = glm::abs(glm::clamp(first, 0.0f, 1.0f) - glm::clamp(second, 0.0f, 1.0f));
+	return glm::max(glm::max(difference.r, difference.g), difference.b) > fAdaptiveContrastThreshold;
+}
+
+// ------------------------------------------------------------------------
+
+// Average color of the square of the given size around (fX, fY), from the
+// samples in the middle of its quarters. A quarter whose sample stands out
+// from the one in the middle of the square or from the other quarters' is
+// split in turn, down to the given depth.
+Radiance RefineSquare(const CameraFrame& camera,
+	float fX,
+	float fY,
+	float fSize,
+	const Radiance& centerColor,
+	const Object* pCenterObject,
+	bool bUseHits,
+	unsigned int uiDepth)
+{
+	Radiance colors[4];
+	const Object* objects[4];
+
+	float fOffset = fSize * 0.25f;
+
+	for (unsigned int uiQuarter = 0; uiQuarter < 4; uiQuarter++)
+	{
+		Ray ray = camera.PrimaryRay(fX + ((uiQuarter & 1) ? fOffset : -fOffset),
+			fY + ((uiQuarter & 2) ? fOffset : -fOffset));
+
+		IntersectionInfo hit = RaySceneIntersection(ray, scene);
+
+		colors[uiQuarter] = Radiance(0.0f);
+		pShadeFunction(ray, hit, colors[uiQuarter], scene, 0, 0, AmbientRefractiveIndex);
+		objects[uiQuarter] = hit.HitObject;
+	}
+
+	Radiance colorSum(0.0f);
+
+	for (unsigned int uiQuarter = 0; uiQuarter < 4; uiQuarter++)
+	{
+		bool bEdge = false;
+		if (uiDepth > 1)
+		{
+			bEdge = HighContrast(colors[uiQuarter], centerColor) ||
+				(bUseHits == true && objects[uiQuarter] != pCenterObject);
+
+			for (unsigned int uiOther = 0; uiOther < 4 && bEdge == false; uiOther++)
+			{
+				bEdge = HighContrast(colors[uiQuarter], colors[uiOther]) ||
+					(bUseHits == true && objects[uiQuarter] != objects[uiOther]);
+			}
+		}
+
+		if (bEdge == true)
+		{
+			colorSum += RefineSquare(camera,
+				fX + ((uiQuarter & 1) ? fOffset : -fOffset),
+				fY + ((uiQuarter & 2) ? fOffset : -fOffset),
+				fSize * 0.5f,
+				colors[uiQuarter],
+				objects[uiQuarter],
+				bUseHits,
+				uiDepth - 1);
+		}
+		else
+		{
+			colorSum += colors[uiQuarter];
+		}
+	}
+
+	return colorSum * 0.25f;
+}
+
+// ------------------------------------------------------------------------
+
+// Second pass of the adaptive frames. The pixels whose middle sample stands
+// out from one of their neighbours', or hit another object, are refined,
+// the others keep it.
+void RefineTile(const Tile& tile)
+{
+	const CameraFrame camera(CurrentCameraSignature());
+
+	Sampler& sampler = GetThreadSampler();
+	sampler.SetPattern(eSamplePattern);
+
+	// Without the G-buffer only the colors tell the edges
+	const bool bUseHits = (eGBufferUse != keGBUFFER_UNUSED);
+
+	unsigned int uiRefinedCount = 0;
+
+	for (int iRow = (int)tile.StartY; iRow < (int)tile.EndY; iRow++)
+	{
+		for (int iColumn = (int)tile.StartX; iColumn < (int)tile.EndX; iColumn++)
+		{
+			int iPixel = iColumn + iRow * iWidth;
+			Radiance centerColor(centerColors[iPixel]);
+			const Object* pCenterObject = bUseHits ? gBuffer[iPixel].HitObject : nullptr;
+
+			auto differs = [&](int iNeighbour)
+			{
+				return HighContrast(centerColor, Radiance(centerColors[iNeighbour])) ||
+					(bUseHits == true && gBuffer[iNeighbour].HitObject != pCenterObject);
+			};
+
+			bool bEdge = (iColumn > 0 && differs(iPixel - 1)) ||
+				(iColumn + 1 < (int)iWidth && differs(iPixel + 1)) ||
+				(iRow > 0 && differs(iPixel - (int)iWidth)) ||
+				(iRow + 1 < (int)iHeight && differs(iPixel + (int)iWidth));
+
+			if (bEdge == false)
+			{
+				accumulation[iPixel] = centerColors[iPixel];
+				continue;
+			}
+
+			sampler.StartPixel(iColumn, iRow, uiFrameIndex, RandomSeed);
+
+			Radiance color = RefineSquare(camera, (float)iColumn, (float)iRow, 1.0f, centerColor, pCenterObject, bUseHits, uiAdaptiveDepth);
+			accumulation[iPixel] = glm::vec4(color, 1.0f);
+
+			uiRefinedCount++;
+		}
+	}
+
+	uiRefinedPixelCount += uiRefinedCount;
+
+	Tonemap(tile);
+}
+
+// ------------------------------------------------------------------------
+
+void InitRenderer(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiWorkerCount)
+{
+	iWidth = uiWidth;
+	iHeight = uiHeight;
+
+	delete[] pixels;
+	pixels = new sf::Uint8[iWidth * iHeight * 4];
+	memset(pixels, 0, iWidth * iHeight * 4);
+
+	delete[] accumulation;
+	accumulation = new glm::vec4[iWidth * iHeight];
+	std::fill(accumulation, accumulation + iWidth * iHeight, glm::vec4(0.0f));
+
+	// A resize starts a new average
+	uiProgressiveSampleCount = 0;
+
+	// Allocated by the first frame which uses it
+	gBuffer.clear();
+	bGBufferValid = false;
+	bGBufferFilled = false;
+
+	tileDependencies.clear();
+	bDependenciesValid = false;
+	pendingMoves.clear();
+
+	delete[] historyColors;
+	historyColors = nullptr;
+	shadingOrigins.clear();
+	historyHits.clear();
+	historyShadingOrigins.clear();
+	bHistoryValid = false;
+
+	delete[] centerColors;
+	centerColors = nullptr;
+
+#ifdef MULTITHREADING
+
+	if (m_TileScheduler == nullptr)
+	{
+		m_TileScheduler = std::make_unique<TileScheduler>(uiWorkerCount);
+
+		std::cout << "Render workers: " << m_TileScheduler->GetWorkerCount() << std::endl;
+	}
+
+	// Split the image in tiles
+	m_TileScheduler->SetupTiles(iWidth, iHeight, iTileSize);
+
+#endif // MULTITHREADING
+}
+
+// ------------------------------------------------------------------------
+
+void ShutdownRenderer()
+{
+#ifdef MULTITHREADING
+	m_TileScheduler.reset();
+#endif // MULTITHREADING
+
+	delete[] pixels;
+	pixels = nullptr;
+
+	delete[] accumulation;
+	accumulation = nullptr;
+
+	std::vector<IntersectionInfo>().swap(gBuffer);
+	bGBufferValid = false;
+	bGBufferFilled = false;
+
+	std::vector<TileDependencies>().swap(tileDependencies);
+	bDependenciesValid = false;
+	pendingMoves.clear();
+
+	delete[] historyColors;
+	historyColors = nullptr;
+	std::vector<ShadingOrigin>().swap(shadingOrigins);
+	std::vector<IntersectionInfo>().swap(historyHits);
+	std::vector<ShadingOrigin>().swap(historyShadingOrigins);
+	bHistoryValid = false;
+
+	delete[] centerColors;
+	centerColors = nullptr;
+}
+
+// ------------------------------------------------------------------------
+
+FrameSignature CurrentFrameSignature()
+{
+	FrameSignature signature;
+
+	signature.CameraPosition = pCam->GetCameraPosition();
+	signature.CameraTarget = pCam->GetCameraTarget();
+	signature.CameraUp = pCam->GetCameraUp();
+
+	signature.MaxReflectionDepth = MAX_REFLECTION_DEPTH;
+	signature.MaxRefractionDepth = MAX_REFRACTION_DEPTH;
+	signature.SquareLength = SquareLength;
+	signature.SampleCount = SampleCount;
+
+	signature.ShadowsEnabled = ShadowsEnabled;
+	signature.SoftShadowsEnabled = SoftShadowsEnabled;
+	signature.SuperSamplingEnabled = SuperSamplingEnabled;
+	signature.AdaptiveSuperSamplingEnabled = AdaptiveSuperSamplingEnabled;
+	signature.PlaneTexturingEnabled = PlaneTexturingEnabled;
+	signature.ReflectionEnabled = ReflectionEnabled;
+	signature.RefractionEnabled = RefractionEnabled;
+
+	signature.ContributionThreshold = ContributionThreshold;
+	signature.RussianRouletteEnabled = RussianRouletteEnabled;
+	signature.AreaLightSampleLimit = AreaLightSampleLimit;
+
+	signature.LightModel = eLightModel;
+	signature.Pattern = eSamplePattern;
+	signature.Seed = RandomSeed;
+
+	return signature;
+}
+
+// ------------------------------------------------------------------------
+
+CameraSignature CurrentCameraSignature()
+{
+	CameraSignature signature;
+
+	signature.Position = pCam->GetCameraPosition();
+	signature.Target = pCam->GetCameraTarget();
+	signature.Up = pCam->GetCameraUp();
+	signature.HorizontalFOV = pCam->GetHorizontalFOV();
+	signature.VerticalFOV = pCam->GetVerticalFOV();
+
+	return signature;
+}
+
+// ------------------------------------------------------------------------
+
+// Keep the moves of bounded objects other than lights until a frame is
+// drawn. Returns false if anything else changed: objects were added, or a
+// light or an unbounded object moved, which can change any pixel.
+bool AddPendingMoves(const std::vector<ObjectMove>& moves)
+{
+	if (moves.empty() == true)
+	{
+		return false;
+	}
+
+	for (const ObjectMove& move : moves)
+	{
+		if (move.MovedObject->IsLight() == true ||
+			move.OldBounds.IsValid() == false ||
+			move.NewBounds.IsValid() == false)
+		{
+			return false;
+		}
+
+		pendingMoves.push_back(move);
+	}
+
+	return true;
+}
+
+// ------------------------------------------------------------------------
+
+// Pixels whose primary rays can hit the box, clipped to the image. Returns
+// false if there are none.
+bool ProjectBounds(const AABB& bounds, Tile& rect)
+{
+	const CameraFrame camera(CurrentCameraSignature());
+
+	glm::vec2 minPixel(std::numeric_limits<float>::max());
+	glm::vec2 maxPixel(std::numeric_limits<float>::lowest());
+
+	for (unsigned int uiCorner = 0; uiCorner < 8; uiCorner++)
+	{
+		glm::vec3 corner((uiCorner & 1) ? bounds.Max.x : bounds.Min.x,
+			(uiCorner & 2) ? bounds.Max.y : bounds.Min.y,
+			(uiCorner & 4) ? bounds.Max.z : bounds.Min.z);
+
+		// A box reaching behind the camera can cover any pixel
+		glm::vec2 pixel;
+		if (camera.Project(corner, pixel) == false)
+		{
+			rect = { 0, 0, iWidth, iHeight };
+			return true;
+		}
+
+		minPixel = glm::min(minPixel, pixel);
+		maxPixel = glm::max(maxPixel, pixel);
+	}
+
+	// One pixel of margin for the rounding
+	int iStartX = glm::max((int)std::floor(minPixel.x) - 1, 0);
+	int iStartY = glm::max((int)std::floor(minPixel.y) - 1, 0);
+	int iEndX = glm::min((int)std::ceil(glm::min(maxPixel.x, (float)iWidth)) + 2, (int)iWidth);
+	int iEndY = glm::min((int)std::ceil(glm::min(maxPixel.y, (float)iHeight)) + 2, (int)iHeight);
+
+	if (iStartX >= iEndX || iStartY >= iEndY)
+	{
+		return false;
+	}
+
+	rect = { (unsigned int)iStartX, (unsigned int)iStartY, (unsigned int)iEndX, (unsigned int)iEndY };
+	return true;
+}
+
+// ------------------------------------------------------------------------
+
+// A tile has to be traced again if a moved object covers it on screen
+// before or after the move, or if its rays hit the object, or if its
+// bounces can reach the object's new position, or its shadow rays either
+// position. Returns the number of dirty tiles.
+unsigned int MarkDirtyTiles()
+{
+	unsigned int uiColumnCount = GetTileColumnCount();
+
+	dirtyTiles.assign(tileDependencies.size(), false);
+
+	for (const ObjectMove& move : pendingMoves)
+	{
+		Tile oldRect, newRect;
+		bool bOldVisible = ProjectBounds(move.OldBounds, oldRect);
+		bool bNewVisible = ProjectBounds(move.NewBounds, newRect);
+
+		for (unsigned int uiTile = 0; uiTile < tileDependencies.size(); uiTile++)
+		{
+			if (dirtyTiles[uiTile] == true)
+			{
+				continue;
+			}
+
+			unsigned int uiStartX = (uiTile % uiColumnCount) * iTileSize;
+			unsigned int uiStartY = (uiTile / uiColumnCount) * iTileSize;
+
+			auto overlaps = [&](const Tile& rect)
+			{
+				return rect.StartX < uiStartX + iTileSize && uiStartX < rect.EndX &&
+					rect.StartY < uiStartY + iTileSize && uiStartY < rect.EndY;
+			};
+
+			const TileDependencies& dependencies = tileDependencies[uiTile];
+
+			dirtyTiles[uiTile] = (bOldVisible == true && overlaps(oldRect)) ||
+				(bNewVisible == true && overlaps(newRect)) ||
+				dependencies.Hit(move.MovedObject) ||
+				dependencies.BouncesMayReach(move.NewBounds) ||
+				dependencies.ShadowRaysMayReach(move.OldBounds) ||
+				dependencies.ShadowRaysMayReach(move.NewBounds);
+		}
+	}
+
+	unsigned int uiDirtyCount = 0;
+	for (unsigned int uiTile = 0; uiTile < dirtyTiles.size(); uiTile++)
+	{
+		uiDirtyCount += dirtyTiles[uiTile] ? 1 : 0;
+	}
+
+	return uiDirtyCount;
+}
+
+// ------------------------------------------------------------------------
+
+void RenderFrame()
+{
+	// Rebuild the acceleration structure if the scene changed
+	std::vector<ObjectMove> movedObjects;
+	bool bSceneChanged = scene.UpdateAccelerationStructure(&movedObjects);
+
+	// Moved objects only dirty the tiles which depend on them, anything else
+	// the whole image
+	if (bSceneChanged == true && AddPendingMoves(movedObjects) == false)
+	{
+		bDependenciesValid = false;
+	}
+
+	// Only camera moves are reprojected
+	if (bSceneChanged == true)
+	{
+		bHistoryValid = false;
+	}
+
+	// The kept primary hits are lost as soon as the geometry or the camera
+	// changes, even if this frame doesn't draw anything
+	CameraSignature cameraSignature = CurrentCameraSignature();
+	if (bSceneChanged == true || (cameraSignature == gBufferCamera) == false)
+	{
+		bGBufferValid = false;
+	}
+
+	// ------------------------------------------------------------------------
+	// Progressive accumulation
+
+	bProgressiveFrame = (Realtime == true && ProgressiveEnabled == true);
+
+	if (bProgressiveFrame == true)
+	{
+		FrameSignature signature = CurrentFrameSignature();
+
+		// Start a new average if anything the image depends on changed
+		if (bSceneChanged == true || UpdateRequired == true || (signature == lastFrameSignature) == false)
+		{
+			uiProgressiveSampleCount = 0;
+			lastFrameSignature = signature;
+		}
+
+		// Converged, the pixels already hold the final image
+		if (uiProgressiveSampleCount >= iProgressiveSampleLimit)
+		{
+			UpdateRequired = false;
+			return;
+		}
+	}
+	else
+	{
+		uiProgressiveSampleCount = 0;
+	}
+
+	// ------------------------------------------------------------------------
+
+	// The settings can change from the UI thread at any time, every tile of
+	// the frame uses the ones read here
+	pTraceFunction = traceTable[CurrentRenderFeatures()];
+	pShadeFunction = shadeTable[CurrentRenderFeatures()];
+	pWavefrontFunction = wavefrontTable[CurrentRenderFeatures()];
+
+	// ------------------------------------------------------------------------
+	// Primary hit cache
+
+	// The hits only hold for the unjittered sample in the middle of the pixels
+	bool bDrawFrame = (Realtime == true || UpdateRequired == true);
+
+	// Super sampled frames take a sample in the middle of every pixel first
+	// when they are adaptive
+	bAdaptiveFrame = (bDrawFrame == true &&
+		bProgressiveFrame == false &&
+		SuperSamplingEnabled == true &&
+		SampleCount > 1 &&
+		AdaptiveSuperSamplingEnabled == true);
+
+	uiAdaptiveDepth = 1;
+	while ((1 << (uiAdaptiveDepth + 1)) <= SampleCount)
+	{
+		uiAdaptiveDepth++;
+	}
+
+	eGBufferUse = keGBUFFER_UNUSED;
+	if (GBufferEnabled == true && bProgressiveFrame == false && (SuperSamplingEnabled == false || SampleCount <= 1 || bAdaptiveFrame == true))
+	{
+		if (gBuffer.size() != iWidth * iHeight)
+		{
+			gBuffer.resize(iWidth * iHeight);
+			shadingOrigins.resize(iWidth * iHeight);
+			bGBufferValid = false;
+		}
+
+		eGBufferUse = (bGBufferValid == true) ? keGBUFFER_REUSE : keGBUFFER_STORE;
+	}
+
+	FrameSignature frameSignature = CurrentFrameSignature();
+
+	// ------------------------------------------------------------------------
+	// Temporal reprojection
+
+	// A frame whose hits have to be found again because the camera moved
+	// reuses the colors of the last frame where it sees the same points, if
+	// nothing else changed since
+	bReprojectFrame = (ReprojectionEnabled == true &&
+		bDrawFrame == true &&
+		bAdaptiveFrame == false &&
+		eGBufferUse == keGBUFFER_STORE &&
+		bHistoryValid == true &&
+		frameSignature.SameSettings(historySignature));
+
+	uiReprojectedPixelCount = 0;
+
+	if (bReprojectFrame == true)
+	{
+		// The last frame's buffers become the history, the frame fills the
+		// ones of the frame before
+		if (historyColors == nullptr)
+		{
+			historyColors = new glm::vec4[iWidth * iHeight];
+		}
+
+		std::swap(accumulation, historyColors);
+		gBuffer.swap(historyHits);
+		shadingOrigins.swap(historyShadingOrigins);
+
+		gBuffer.resize(iWidth * iHeight);
+		shadingOrigins.resize(iWidth * iHeight);
+	}
+
+	// ------------------------------------------------------------------------
+	// Dirty tiles
+
+	// The dependencies are recorded by every frame with one sample per pixel
+	// at its center, or its fixed super samples. A frame which only has to
+	// show moved objects traces the tiles which depended on them.
+	bRecordDependencies = false;
+	bPartialFrame = false;
+
+	unsigned int uiTileCount = GetTileColumnCount() * ((iHeight + iTileSize - 1) / iTileSize);
+	uiTracedTileCount = (bDrawFrame == true) ? uiTileCount : 0;
+
+#ifdef MULTITHREADING
+
+	// The pixels of a reprojected frame don't all trace their rays, the edges
+	// of an adaptive one depend on the samples of the neighbouring tiles
+	if (DirtyTilesEnabled == true && bDrawFrame == true && bProgressiveFrame == false && bReprojectFrame == false &&
+		bAdaptiveFrame == false)
+	{
+		bRecordDependencies = true;
+
+		if (tileDependencies.size() != uiTileCount)
+		{
+			tileDependencies.resize(uiTileCount);
+			bDependenciesValid = false;
+		}
+
+		bPartialFrame = (bDependenciesValid == true &&
+			pendingMoves.empty() == false &&
+			frameSignature == dependencySignature &&
+			cameraSignature == dependencyCamera);
+
+		if (bPartialFrame == true)
+		{
+			uiTracedTileCount = MarkDirtyTiles();
+		}
+	}
+
+#endif // MULTITHREADING
+
+	// ------------------------------------------------------------------------
+
+#ifdef MULTITHREADING
+
+	// Render all the tiles and wait for the frame to finish
+	m_TileScheduler->Run(&Render);
+
+#else
+
+	Tile fullImage = { 0, 0, iWidth, iHeight };
+	Render(fullImage);
+
+#endif // MULTITHREADING
+
+	// Refine the edges once the middle samples of all the tiles are known
+	uiRefinedPixelCount = 0;
+
+	if (bAdaptiveFrame == true)
+	{
+		if (centerColors == nullptr)
+		{
+			centerColors = new glm::vec4[iWidth * iHeight];
+		}
+
+		std::swap(accumulation, centerColors);
+
+#ifdef MULTITHREADING
+
+		m_TileScheduler->Run(&RefineTile);
+
+#else
+
+		RefineTile(fullImage);
+
+#endif // MULTITHREADING
+	}
+
+	if (bDrawFrame == true)
+	{
+		// A partial frame only stores the hits of its dirty tiles, the
+		// others still hold the ones of the frames before
+		bGBufferFilled = (eGBufferUse != keGBUFFER_UNUSED && (bPartialFrame == false || bGBufferFilled == true));
+
+		if (eGBufferUse == keGBUFFER_STORE && bGBufferFilled == true)
+		{
+			bGBufferValid = true;
+			gBufferCamera = cameraSignature;
+		}
+
+		bDependenciesValid = bRecordDependencies;
+		dependencySignature = frameSignature;
+		dependencyCamera = cameraSignature;
+		pendingMoves.clear();
+
+		// A filled G-buffer comes with one sample per pixel in the
+		// accumulation buffer, unless the edges were refined
+		bHistoryValid = (bGBufferFilled == true && bAdaptiveFrame == false);
+		historySignature = frameSignature;
+		historyCamera = cameraSignature;
+	}
+
+	// Update done
+	UpdateRequired = false;
+	uiFrameIndex++;
+
+	if (bProgressiveFrame == true)
+	{
+		uiProgressiveSampleCount++;
+	}
+}
+
+// ------------------------------------------------------------------------
+
+unsigned int GetProgressiveSampleCount()
+{
+	return uiProgressiveSampleCount;
+}
+
+// ------------------------------------------------------------------------
+
+unsigned int GetTracedTileCount()
+{
+	return uiTracedTileCount;
+}
+
+// ------------------------------------------------------------------------
+
+unsigned int GetReprojectedPixelCount()
+{
+	return uiReprojectedPixelCount;
+}
+
+// ------------------------------------------------------------------------
+
+unsigned int GetRefinedPixelCount()
+{
+	return uiRefinedPixelCount;
+}
+
+// ------------------------------------------------------------------------
+// Upscaling
+
+// Spread of the color differences the upscale filter still blends over, on
+// the 0-255 scale. Samples further from the nearest one than that barely
+// count, so edges stay sharp.
+const float fUpscaleColorSigma = 24.0f;
+
+// Hits further apart than this fraction of their distance lie on different
+// surfaces
+const float fUpscaleDepthTolerance = 0.05f;
+
+// Output pixels whose position falls in the tile of the frame, each filtered
+// from the four frame pixels around it. The bilinear weights are scaled by
+// how close every sample is to the nearest one in color and, when the
+// G-buffer holds the hits of the frame, whether it hit the same surface.
+void UpscaleTile(const Tile& tile,
+	sf::Uint8* pOutput,
+	unsigned int uiOutputWidth,
+	unsigned int uiOutputHeight,
+	bool bUseHits)
+{
+	// The primary rays go through the integer positions of both images
+	float fScaleX = (float)iWidth / uiOutputWidth;
+	float fScaleY = (float)iHeight / uiOutputHeight;
+
+	unsigned int uiStartX = (unsigned int)std::ceil(tile.StartX / fScaleX);
+	unsigned int uiEndX = glm::min((unsigned int)std::ceil(tile.EndX / fScaleX), uiOutputWidth);
+	unsigned int uiStartY = (unsigned int)std::ceil(tile.StartY / fScaleY);
+	unsigned int uiEndY = glm::min((unsigned int)std::ceil(tile.EndY / fScaleY), uiOutputHeight);
+
+	const float fColorFalloff = 1.0f / (2.0f * fUpscaleColorSigma * fUpscaleColorSigma);
+
+	for (unsigned int uiY = uiStartY; uiY < uiEndY; uiY++)
+	{
+		float fY = uiY * fScaleY;
+		unsigned int uiY0 = glm::min((unsigned int)fY, iHeight - 1);
+		unsigned int uiY1 = glm::min(uiY0 + 1, iHeight - 1);
+		float fWeightY = fY - uiY0;
+
+		for (unsigned int uiX = uiStartX; uiX < uiEndX; uiX++)
+		{
+			float fX = uiX * fScaleX;
+			unsigned int uiX0 = glm::min((unsigned int)fX, iWidth - 1);
+			unsigned int uiX1 = glm::min(uiX0 + 1, iWidth - 1);
+			float fWeightX = fX - uiX0;
+
+			unsigned int samples[4] = {
+				uiX0 + uiY0 * iWidth,
+				uiX1 + uiY0 * iWidth,
+				uiX0 + uiY1 * iWidth,
+				uiX1 + uiY1 * iWidth };
+
+			float weights[4] = {
+				(1.0f - fWeightX) * (1.0f - fWeightY),
+				fWeightX * (1.0f - fWeightY),
+				(1.0f - fWeightX) * fWeightY,
+				fWeightX * fWeightY };
+
+			unsigned int uiNearest = (fWeightX < 0.5f ? 0 : 1) + (fWeightY < 0.5f ? 0 : 2);
+			const sf::Uint8* pNearest = pixels + 4 * samples[uiNearest];
+
+			glm::vec3 colorSum(0.0f);
+			float fWeightSum = 0.0f;
+
+			for (unsigned int index = 0; index < 4; index++)
+			{
+				const sf::Uint8* pSample = pixels + 4 * samples[index];
+				glm::vec3 color(pSample[0], pSample[1], pSample[2]);
+
+				glm::vec3 difference = color - glm::vec3(pNearest[0], pNearest[1], pNearest[2]);
+				float fWeight = weights[index] * std::exp(-glm::dot(difference, difference) * fColorFalloff);
+
+				if (bUseHits == true)
+				{
+					const IntersectionInfo& hit = gBuffer[samples[index]];
+					const IntersectionInfo& nearestHit = gBuffer[samples[uiNearest]];
+
+					if (hit.HitObject != nearestHit.HitObject ||
+						(hit.HitObject != NULL &&
+						glm::abs(hit.RayLength - nearestHit.RayLength) > fUpscaleDepthTolerance * nearestHit.RayLength))
+					{
+						fWeight = 0.0f;
+					}
+				}
+
+				colorSum += color * fWeight;
+				fWeightSum += fWeight;
+			}
+
+			// The nearest sample always has some weight, unless it sits
+			// exactly on the far side of the pixel
+			sf::Uint8* pDestination = pOutput + 4 * (uiX + uiY * uiOutputWidth);
+			if (fWeightSum > 1e-6f)
+			{
+				colorSum /= fWeightSum;
+				pDestination[0] = (sf::Uint8)(colorSum.r + 0.5f);
+				pDestination[1] = (sf::Uint8)(colorSum.g + 0.5f);
+				pDestination[2] = (sf::Uint8)(colorSum.b + 0.5f);
+			}
+			else
+			{
+				memcpy(pDestination, pNearest, 3);
+			}
+			pDestination[3] = 255;
+		}
+	}
+}
+
+// ------------------------------------------------------------------------
+
+void UpscaleFrame(sf::Uint8* pOutput, unsigned int uiOutputWidth, unsigned int uiOutputHeight)
+{
+	if (uiOutputWidth == iWidth && uiOutputHeight == iHeight)
+	{
+		memcpy(pOutput, pixels, iWidth * iHeight * 4);
+		return;
+	}
+
+	bool bUseHits = (bGBufferFilled == true && gBuffer.size() == iWidth * iHeight);
+
+	auto upscale = [&](const Tile& tile)
+	{
+		UpscaleTile(tile, pOutput, uiOutputWidth, uiOutputHeight, bUseHits);
+	};
+
+#ifdef MULTITHREADING
+
+	m_TileScheduler->Run(upscale);
+
+#else
+
+	Tile fullImage = { 0, 0, iWidth, iHeight };
+	upscale(fullImage);
+
+#endif // MULTITHREADING
+}
+
+// ------------------------------------------------------------------------
\ No newline at end of file
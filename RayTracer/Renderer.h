@@ -0,0 +1,149 @@
+#ifndef __RENDERER_H__
+#define __RENDERER_H__
+
+#include <memory>
+
+#include "Common.h"
+#include "Camera.h"
+#include "Scene.h"
+#include "TileScheduler.h"
+#include "Random.h"
+
+// ----------------------------------------------------------------------------
+// Ray tracing core shared by the interactive and the headless front ends. It
+// only depends on the scene, the camera and the pixel buffer, no window or
+// GUI code lives here.
+// ----------------------------------------------------------------------------
+
+enum LightingModel
+{
+	Phong = 0,
+	BlinnPhong,
+
+	InvalidLightModel,
+};
+
+// ----------------------------------------------------------------------------
+// Render settings, modifiable from the UI
+
+extern unsigned int MAX_REFLECTION_DEPTH;
+extern unsigned int MAX_REFRACTION_DEPTH;
+
+extern int SquareLength;
+extern int SampleCount;
+extern float SampleDistance;
+
+extern const float AmbientRefractiveIndex;
+
+extern bool UpdateRequired;
+extern bool Realtime;
+extern bool ShadowsEnabled;
+extern bool SoftShadowsEnabled;
+extern bool SuperSamplingEnabled;
+
+// Super sample only the pixels on edges: every pixel gets the sample in its
+// middle, and the ones whose color stands out from a neighbour's or which
+// see another object are split into quarters, recursively while the quarters
+// differ, up to SampleCount x SampleCount samples. Outside progressive mode.
+extern bool AdaptiveSuperSamplingEnabled;
+extern bool PlaneTexturingEnabled;
+extern bool ReflectionEnabled;
+extern bool RefractionEnabled;
+
+// In real-time mode, add one jittered sample per pixel to a running average
+// while the camera, the scene and the settings don't change
+extern bool ProgressiveEnabled;
+
+// Trace the primary rays of every 8x8 pixel block as one packet through the
+// acceleration structures, one sample per pixel only
+extern bool PacketTracingEnabled;
+
+// Trace the rays of a tile breadth first, a bounce generation at a time with
+// the rays and shadow rays of each generation sorted by origin and direction,
+// instead of following every pixel's reflections and refractions depth first.
+// One sample per pixel only.
+extern bool WavefrontEnabled;
+
+// Reflected and refracted rays whose weight along the path (reflectivity,
+// transparency and Fresnel factors) is below the threshold aren't traced, 0
+// traces them all. With Russian roulette they are traced with a probability
+// proportional to their weight instead, which keeps the image unbiased.
+extern float ContributionThreshold;
+extern bool RussianRouletteEnabled;
+
+// Keep the primary hit of every pixel while the camera and the geometry
+// don't change, so changes to the lights, materials or other settings only
+// shade the pixels again. Used by the frames with one sample per pixel
+// outside progressive mode.
+extern bool GBufferEnabled;
+
+// Record what the rays of every tile hit and where they went. When objects
+// only move, the next frame then traces the tiles which can see them or
+// their shadows before or after the move, and keeps the other pixels.
+// Outside progressive mode only.
+extern bool DirtyTilesEnabled;
+
+// When only the camera moved, reuse the last frame's color of the pixels
+// which see the same point of the same surface again, and shade the others.
+// Specular, reflective and refractive surfaces are shaded again once the
+// direction they are seen from turned by more than a degree. Used by the
+// frames which keep a G-buffer.
+extern bool ReprojectionEnabled;
+
+// Most samples a surface point takes from every area light in the frames
+// outside progressive mode, 0 takes the full set. The cells taken move on
+// from frame to frame.
+extern unsigned int AreaLightSampleLimit;
+
+extern LightingModel eLightModel;
+
+// Area light sample placement and the seed mixed into every pixel's samples
+extern SamplePattern eSamplePattern;
+extern unsigned int RandomSeed;
+
+// ----------------------------------------------------------------------------
+// Frame
+
+extern unsigned int iWidth;
+extern unsigned int iHeight;
+
+// RGBA, 4 bytes per pixel, written by the tonemap pass
+extern sf::Uint8* pixels;
+
+// Linear radiance of every pixel (rgb) and the weight of its samples (a)
+extern glm::vec4* accumulation;
+
+extern Scene scene;
+extern std::shared_ptr<Camera> pCam;
+
+// ----------------------------------------------------------------------------
+
+// Allocate the pixel buffer and start the render workers. A worker count of
+// 0 uses one worker per hardware thread.
+void InitRenderer(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiWorkerCount = 0);
+void ShutdownRenderer();
+
+// Update the acceleration structure and trace every pixel of the frame
+void RenderFrame();
+
+// Samples per pixel in the progressive average, 0 outside progressive mode
+unsigned int GetProgressiveSampleCount();
+
+// Tiles traced by the last frame, fewer than all of them if only objects moved
+unsigned int GetTracedTileCount();
+
+// Pixels of the last frame whose color was reprojected from the frame before
+unsigned int GetReprojectedPixelCount();
+
+// Pixels of the last frame which the adaptive super sampling refined
+unsigned int GetRefinedPixelCount();
+
+// Scale the last frame to the output size, which may differ from the one
+// the renderer was initialized with. The filter keeps the edges between
+// surfaces and colors sharp instead of blurring them. RGBA, 4 bytes per
+// pixel.
+void UpscaleFrame(sf::Uint8* pOutput, unsigned int uiOutputWidth, unsigned int uiOutputHeight);
+
+// ----------------------------------------------------------------------------
+
+#endif // __RENDERER_H__
\ No newline at end of file
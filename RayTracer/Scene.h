@@ -2,18 +2,35 @@
 #define __SCENE_H__
 
 #include <vector>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
 
 #include "Object.h"
+#include "BVH.h"
+#include "Sphere.h"
+#include "Box.h"
+#include "SpherePool.h"
 
 #include "PointLight.h"
 #include "DirectionalLight.h"
-#include "Triangle.h"
 #include "AreaLight.h"
 
+// Object moved since the last update of the acceleration structure. The
+// bounds are invalid for unbounded objects (e.g. planes).
+struct ObjectMove
+{
+	Object* MovedObject;
+	AABB OldBounds;
+	AABB NewBounds;
+};
+
+// ----------------------------------------------------------------------------
+
 class Scene
 {
 public:
-	Scene() {}
+	Scene() : m_bAccelerationStructureDirty(true) {}
 	~Scene() 
 	{
 		for (size_t index = 0; index < m_ObjectList.size(); index++)
@@ -40,6 +57,9 @@ public:
 		// Add object to the general list
 		m_ObjectList.push_back(newObject);
 
+		// The acceleration structure has to include the new object
+		m_bAccelerationStructureDirty = true;
+
 		// Add point light reference
 		if (newObject->Type() == ObjectType::kePOINTLIGHT)
 		{
@@ -81,10 +101,360 @@ public:
 	}
 
 	// ---------------------------------------------------------------------------
+	// Acceleration structure
+
+	inline void InvalidateAccelerationStructure() { m_bAccelerationStructureDirty = true; }
+
+	// Called when an object's bounds changed (e.g. moved from the UI). Only the
+	// object's leaf is refitted on the next update. Safe to call from the UI
+	// thread while a frame is being rendered.
+	inline void MarkObjectMoved(Object* movedObject)
+	{
+		std::lock_guard<std::mutex> lock(m_MovedObjectMutex);
+		m_MovedObjectList.push_back(movedObject);
+	}
+
+	inline float GetRebuildThreshold() const { return m_fRebuildThreshold; }
+	inline void SetRebuildThreshold(float fThreshold) { m_fRebuildThreshold = fThreshold; }
+
+	// Rebuild the hierarchy if objects were added since the last build, refit
+	// it if objects only moved. Must not be called while rays are being traced.
+	// Returns true if any object was added or moved since the last update.
+	// pMoves, if given, receives the moved objects when nothing but moves
+	// changed; it is left empty when objects were added.
+	inline bool UpdateAccelerationStructure(std::vector<ObjectMove>* pMoves = nullptr)
+	{
+		std::vector<Object*> movedObjectList;
+		{
+			std::lock_guard<std::mutex> lock(m_MovedObjectMutex);
+			movedObjectList.swap(m_MovedObjectList);
+		}
+
+		if (m_bAccelerationStructureDirty == true)
+		{
+			BuildAccelerationStructure();
+			return true;
+		}
+
+		if (movedObjectList.empty() == true)
+		{
+			return false;
+		}
+
+		// Update the bounds of the moved objects and refit their leaves
+		for (Object* obj : movedObjectList)
+		{
+			ObjectMove move = { obj, AABB(), AABB() };
+
+			AABB bounds;
+			if (obj->GetBoundingBox(bounds) == false)
+			{
+				// Unbounded objects aren't part of the hierarchy
+				if (pMoves != nullptr)
+				{
+					pMoves->push_back(move);
+				}
+				continue;
+			}
+
+			move.NewBounds = bounds;
+
+			auto sphereIterator = m_SphereIndex.find(obj);
+			auto objectIterator = m_BoundedObjectIndex.find(obj);
+
+			if (sphereIterator != m_SphereIndex.end())
+			{
+				// Spheres also keep a copy of their center in the pool
+				move.OldBounds = m_SphereBVH.GetPrimitiveBounds(sphereIterator->second);
+				m_SphereBVH.UpdatePrimitiveBounds(sphereIterator->second, bounds);
+				m_SpherePool.UpdateSphere(sphereIterator->second);
+			}
+			else if (objectIterator != m_BoundedObjectIndex.end())
+			{
+				move.OldBounds = m_BVH.GetPrimitiveBounds(objectIterator->second);
+				m_BVH.UpdatePrimitiveBounds(objectIterator->second, bounds);
+			}
+
+			if (pMoves != nullptr)
+			{
+				pMoves->push_back(move);
+			}
+		}
+
+		m_BVH.Refit();
+		m_SphereBVH.Refit();
+
+		// The topology was chosen for the old positions. Once the refitted tree
+		// got too expensive to traverse it's cheaper to build a new one.
+		if (m_BVH.QualityRatio() > m_fRebuildThreshold ||
+			m_SphereBVH.QualityRatio() > m_fRebuildThreshold)
+		{
+			BuildAccelerationStructure();
+		}
+
+		return true;
+	}
+
+	inline void BuildAccelerationStructure()
+	{
+		m_BoundedObjectList.clear();
+		m_UnboundedObjectList.clear();
+		m_BoundedObjectIndex.clear();
+		m_SphereIndex.clear();
+
+		std::vector<AABB> objectBounds;
+		objectBounds.reserve(m_ObjectList.size());
+
+		std::vector<Sphere*> sphereList;
+		std::vector<AABB> sphereBounds;
+
+		// Split the objects into spheres, which go in the sphere pool, other
+		// finite ones, which go in the hierarchy, and infinite ones (planes)
+		// which are always tested
+		for (Object* obj : m_ObjectList)
+		{
+			if (obj == nullptr)
+			{
+				continue;
+			}
+
+			AABB bounds;
+			if (obj->Type() == ObjectType::keSPHERE && obj->GetBoundingBox(bounds) == true)
+			{
+				m_SphereIndex[obj] = (unsigned int)sphereList.size();
+				sphereList.push_back(static_cast<Sphere*>(obj));
+				sphereBounds.push_back(bounds);
+			}
+			else if (obj->GetBoundingBox(bounds) == true)
+			{
+				m_BoundedObjectIndex[obj] = (unsigned int)m_BoundedObjectList.size();
+				m_BoundedObjectList.push_back(obj);
+				objectBounds.push_back(bounds);
+			}
+			else
+			{
+				m_UnboundedObjectList.push_back(obj);
+			}
+		}
+
+		m_BVH.Build(objectBounds);
+
+		// One pool batch per leaf, tested in one go
+		m_SphereBVH.Build(sphereBounds, SpherePool::BATCH_SIZE, true);
+		m_SpherePool.Build(m_SphereBVH, sphereList);
+
+		m_bAccelerationStructureDirty = false;
+	}
+
+	// Bounds of the objects in the hierarchies, infinite ones (planes) left out
+	inline AABB GetBounds() const
+	{
+		AABB bounds = m_BVH.GetBounds();
+		if (m_SphereBVH.Empty() == false)
+		{
+			bounds.Extend(m_SphereBVH.GetBounds());
+		}
+		return bounds;
+	}
+
+	// ---------------------------------------------------------------------------
+
+	// Find the closest intersection along the ray
+	inline IntersectionInfo FindIntersection(const Ray& ray)
+	{
+		IntersectionInfo closestIntersection;
+		float fMinIntersectionDistance = std::numeric_limits<float>::infinity();
+
+		auto intersectObject = [&](Object* obj, float& tMax)
+		{
+			IntersectionInfo intersection = obj->FindIntersection(ray);
+			if (intersection.RayLength > 0 &&
+				intersection.RayLength < tMax)
+			{
+				tMax = intersection.RayLength;
+				closestIntersection = intersection;
+			}
+
+			return false;
+		};
+
+		// Infinite objects first, the closest hit among them shortens the ray
+		for (Object* obj : m_UnboundedObjectList)
+		{
+			intersectObject(obj, fMinIntersectionDistance);
+		}
+
+		auto intersectBoundedObject = [&](unsigned int uiObjectIndex, float& tMax)
+		{
+			return intersectObject(m_BoundedObjectList[uiObjectIndex], tMax);
+		};
+
+		m_BVH.Traverse(ray, fMinIntersectionDistance, intersectBoundedObject);
+
+		// Spheres last, only the closest one gets its normal computed
+		int iClosestSphere = -1;
+
+		auto intersectSphereBatch = [&](int iLeafIndex, float& tMax)
+		{
+			int iSphere = m_SpherePool.Intersect(ray, iLeafIndex, tMax);
+			if (iSphere >= 0)
+			{
+				iClosestSphere = iSphere;
+			}
+
+			return false;
+		};
+
+		m_SphereBVH.TraverseLeaves(ray, fMinIntersectionDistance, intersectSphereBatch);
+
+		if (iClosestSphere >= 0)
+		{
+			closestIntersection = m_SpherePool.GetIntersection(ray, iClosestSphere, fMinIntersectionDistance);
+		}
+
+		return closestIntersection;
+	}
+
+	// ---------------------------------------------------------------------------
+
+	// Closest intersections of all the rays of a packet. A coherent packet
+	// walks the hierarchies once for all of its rays, any other one is traced
+	// ray by ray.
+	inline void FindIntersectionPacket(const RayPacket& packet, IntersectionInfo* results)
+	{
+		if (packet.Coherent == false)
+		{
+			for (unsigned int index = 0; index < packet.Count; index++)
+			{
+				results[index] = FindIntersection(packet.Rays[index]);
+			}
+			return;
+		}
+
+		float tMax[RayPacket::MAX_SIZE];
+		for (unsigned int index = 0; index < packet.Count; index++)
+		{
+			tMax[index] = std::numeric_limits<float>::infinity();
+			results[index] = IntersectionInfo();
+		}
+
+		// Same order as for single rays: infinite objects, the other objects
+		// and the spheres
+		for (Object* obj : m_UnboundedObjectList)
+		{
+			obj->IntersectPacket(packet, 0, packet.Count - 1, tMax, results);
+		}
+
+		auto intersectBoundedObject = [&](unsigned int uiObjectIndex, unsigned int uiFirst, unsigned int uiLast)
+		{
+			m_BoundedObjectList[uiObjectIndex]->IntersectPacket(packet, uiFirst, uiLast, tMax, results);
+		};
+
+		m_BVH.TraversePacket(packet, tMax, intersectBoundedObject);
+
+		int closestSpheres[RayPacket::MAX_SIZE];
+		for (unsigned int index = 0; index < packet.Count; index++)
+		{
+			closestSpheres[index] = -1;
+		}
+
+		auto intersectSphereBatch = [&](int iLeafIndex, unsigned int uiFirst, unsigned int uiLast)
+		{
+			for (unsigned int index = uiFirst; index <= uiLast; index++)
+			{
+				int iSphere = m_SpherePool.Intersect(packet.Rays[index], iLeafIndex, tMax[index]);
+				if (iSphere >= 0)
+				{
+					closestSpheres[index] = iSphere;
+				}
+			}
+		};
+
+		m_SphereBVH.TraversePacketLeaves(packet, tMax, intersectSphereBatch);
+
+		for (unsigned int index = 0; index < packet.Count; index++)
+		{
+			if (closestSpheres[index] >= 0)
+			{
+				results[index] = m_SpherePool.GetIntersection(packet.Rays[index], closestSpheres[index], tMax[index]);
+			}
+		}
+	}
+
+	// ---------------------------------------------------------------------------
+
+	// Any-hit query for shadow rays. Returns true as soon as an object other
+	// than the ignored one blocks the ray before tMax. Light sources don't
+	// occlude.
+	inline bool Occluded(const Ray& ray,
+		float tMax,
+		const Object* pIgnoredObject = nullptr)
+	{
+		for (Object* obj : m_UnboundedObjectList)
+		{
+			if (obj != pIgnoredObject && obj->IsLight() == false && obj->Occluded(ray, tMax))
+			{
+				return true;
+			}
+		}
+
+		bool bOccluded = false;
+
+		auto occludedByObject = [&](unsigned int uiObjectIndex, float& tMaxRay)
+		{
+			Object* obj = m_BoundedObjectList[uiObjectIndex];
+			if (obj != pIgnoredObject && obj->IsLight() == false && obj->Occluded(ray, tMaxRay))
+			{
+				// First blocker found => stop the traversal
+				bOccluded = true;
+			}
+
+			return bOccluded;
+		};
+
+		m_BVH.Traverse(ray, tMax, occludedByObject);
+
+		if (bOccluded == true)
+		{
+			return true;
+		}
+
+		// Spheres are never light sources
+		auto occludedBySphereBatch = [&](int iLeafIndex, float& tMaxRay)
+		{
+			bOccluded = m_SpherePool.Occluded(ray, iLeafIndex, tMaxRay, pIgnoredObject);
+			return bOccluded;
+		};
+
+		m_SphereBVH.TraverseLeaves(ray, tMax, occludedBySphereBatch);
+
+		return bOccluded;
+	}
+
+	// ---------------------------------------------------------------------------
 	
 private:
 	std::vector<Object*> m_ObjectList;
 
+	// Acceleration structure
+	BVH m_BVH;
+	std::vector<Object*> m_BoundedObjectList;
+	std::vector<Object*> m_UnboundedObjectList;
+	std::unordered_map<Object*, unsigned int> m_BoundedObjectIndex;
+	bool m_bAccelerationStructureDirty;
+
+	// Spheres, with their own hierarchy whose leaves are pool batches
+	BVH m_SphereBVH;
+	SpherePool m_SpherePool;
+	std::unordered_map<Object*, unsigned int> m_SphereIndex;
+
+	// Objects moved since the last update
+	std::mutex m_MovedObjectMutex;
+	std::vector<Object*> m_MovedObjectList;
+
+	// Quality ratio past which a refit is replaced by a full rebuild
+	float m_fRebuildThreshold = 1.5f;
+
 	std::vector<PointLight*>		m_PointLightList;
 	std::vector<DirectionalLight*>	m_DirectionalLightList;
 	std::vector<AreaLight*>			m_AreaLightList;
@@ -34,6 +34,34 @@ public:
 	inline glm::vec3 GetPosition() { return m_vCenter; }
 	inline void SetPosition(const glm::vec3& newPosition) { m_vCenter = newPosition; }
 
+	inline bool GetBoundingBox(AABB& bounds) override
+	{
+		bounds = AABB(m_vCenter - glm::vec3(m_fRadius), m_vCenter + glm::vec3(m_fRadius));
+		return true;
+	}
+
+	inline bool Occluded(const Ray& ray, float tMax)
+	{
+		// Solutions
+		float t1, t2;
+
+		// Calculate quadratic's coefficients
+		glm::vec3 L = ray.GetOrigin() - m_vCenter;
+		float a = glm::dot(ray.GetDirection(), ray.GetDirection());
+		float b = 2.0f * glm::dot(ray.GetDirection(), L);
+		float c = glm::dot(L, L) - m_fSqRadius;
+
+		if (SolveQuadratic(a, b, c, t1, t2) == false)
+		{
+			return false;
+		}
+
+		// Use the far solution if the origin is inside the sphere
+		float t = (t1 > 0.0f) ? t1 : t2;
+
+		return t > 0.0f && t < tMax;
+	}
+
 	inline IntersectionInfo FindIntersection(const Ray& ray)
 	{
 		// Solutions
@@ -0,0 +1,400 @@
+#ifndef __SPHEREPOOL_H__
+#define __SPHEREPOOL_H__
+
+#include <vector>
+#include <limits>
+#include <stdint.h>
+
+#include "Common.h"
+#include "Ray.h"
+#include "BVH.h"
+#include "Sphere.h"
+#include "CpuFeatures.h"
+
+// SSE2 is used on every x86 target and plain floats everywhere else. x86
+// builds also get an AVX2 version of the batch test, used instead when the
+// CPU supports it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPHEREPOOL_SSE2
+#include <emmintrin.h>
+#if defined(CPU_X86)
+#define SPHEREPOOL_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+// ----------------------------------------------------------------------------
+// Lane operations used by the batch intersection. Both variants have the same
+// interface so the intersection code is written once.
+
+#if defined(SPHEREPOOL_SSE2)
+
+struct SphereLanesSSE2
+{
+	typedef __m128 Float;
+	typedef __m128 Mask;
+
+	static const unsigned int Width = 4;
+
+	static inline Float Load(const float* pValues) { return _mm_load_ps(pValues); }
+	static inline void Store(float* pValues, Float value) { _mm_storeu_ps(pValues, value); }
+	static inline Float Set(float fValue) { return _mm_set1_ps(fValue); }
+
+	static inline Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+	static inline Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	static inline Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+	static inline Float Div(Float a, Float b) { return _mm_div_ps(a, b); }
+	static inline Float Sqrt(Float a) { return _mm_sqrt_ps(a); }
+	static inline Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+	static inline Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+	static inline Float Negate(Float a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+
+	static inline Mask Greater(Float a, Float b) { return _mm_cmpgt_ps(a, b); }
+	static inline Mask GreaterEqual(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+	static inline Mask Less(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+	static inline Mask Equal(Float a, Float b) { return _mm_cmpeq_ps(a, b); }
+	static inline Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+
+	static inline Float Select(Mask mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	static inline unsigned int Bits(Mask mask) { return (unsigned int)_mm_movemask_ps(mask); }
+};
+
+typedef SphereLanesSSE2 SphereLanes;
+
+#else
+
+struct SphereLanesScalar
+{
+	typedef float Float;
+	typedef bool Mask;
+
+	static const unsigned int Width = 1;
+
+	static inline Float Load(const float* pValues) { return *pValues; }
+	static inline void Store(float* pValues, Float value) { *pValues = value; }
+	static inline Float Set(float fValue) { return fValue; }
+
+	static inline Float Add(Float a, Float b) { return a + b; }
+	static inline Float Sub(Float a, Float b) { return a - b; }
+	static inline Float Mul(Float a, Float b) { return a * b; }
+	static inline Float Div(Float a, Float b) { return a / b; }
+	static inline Float Sqrt(Float a) { return sqrt(a); }
+	static inline Float Min(Float a, Float b) { return (a < b) ? a : b; }
+	static inline Float Max(Float a, Float b) { return (a > b) ? a : b; }
+	static inline Float Negate(Float a) { return -a; }
+
+	static inline Mask Greater(Float a, Float b) { return a > b; }
+	static inline Mask GreaterEqual(Float a, Float b) { return a >= b; }
+	static inline Mask Less(Float a, Float b) { return a < b; }
+	static inline Mask Equal(Float a, Float b) { return a == b; }
+	static inline Mask And(Mask a, Mask b) { return a && b; }
+
+	static inline Float Select(Mask mask, Float a, Float b) { return mask ? a : b; }
+	static inline unsigned int Bits(Mask mask) { return mask ? 1u : 0u; }
+};
+
+typedef SphereLanesScalar SphereLanes;
+
+#endif
+
+// ----------------------------------------------------------------------------
+
+// Structure of arrays copy of the scene's spheres. The spheres are stored in
+// the order of the leaves of a hierarchy built over them, every leaf in its
+// own batch of BATCH_SIZE slots, so one leaf is tested against the ray with
+// one pass over the batch. Unused slots have NaN centers and are never hit.
+class SpherePool
+{
+public:
+	static const unsigned int BATCH_SIZE = 8;
+
+	SpherePool() { }
+
+	SpherePool(const SpherePool&) = delete;
+	SpherePool& operator=(const SpherePool&) = delete;
+
+	// ------------------------------------------------------------------------
+
+	// The hierarchy must have been built over the spheres' bounds, in the
+	// same order, with at most BATCH_SIZE spheres per leaf
+	inline void Build(const BVH& bvh, const std::vector<Sphere*>& spheres)
+	{
+		Clear();
+
+#ifdef SPHEREPOOL_AVX2
+		m_bAVX2 = CpuSupportsAVX2();
+#endif
+
+		const std::vector<BVHNode>& nodes = bvh.Nodes();
+		const std::vector<unsigned int>& primitiveIndices = bvh.PrimitiveIndices();
+
+		m_vLeafBatch.assign(nodes.size(), -1);
+		m_vSphereSlot.assign(spheres.size(), 0);
+
+		unsigned int uiBatchCount = 0;
+		for (unsigned int nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++)
+		{
+			if (nodes[nodeIndex].IsLeaf())
+			{
+				m_vLeafBatch[nodeIndex] = (int)uiBatchCount++;
+			}
+		}
+
+		// The four arrays follow each other in one block. The block is
+		// aligned on 32 bytes and every array is a multiple of 32 bytes long.
+		m_uiSlotCount = uiBatchCount * BATCH_SIZE;
+		m_vStorage.assign(4 * m_uiSlotCount + BATCH_SIZE, std::numeric_limits<float>::quiet_NaN());
+
+		uintptr_t ulAddress = (uintptr_t)m_vStorage.data();
+		float* pBase = m_vStorage.data() + ((32 - (ulAddress & 31)) & 31) / sizeof(float);
+
+		m_pCenterX = pBase;
+		m_pCenterY = pBase + m_uiSlotCount;
+		m_pCenterZ = pBase + 2 * m_uiSlotCount;
+		m_pSqRadius = pBase + 3 * m_uiSlotCount;
+
+		m_vSpheres.assign(m_uiSlotCount, nullptr);
+
+		for (unsigned int nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++)
+		{
+			const BVHNode& node = nodes[nodeIndex];
+			if (node.IsLeaf() == false)
+			{
+				continue;
+			}
+
+			unsigned int uiFirstSlot = m_vLeafBatch[nodeIndex] * BATCH_SIZE;
+			for (unsigned int index = 0; index < node.PrimitiveCount && index < BATCH_SIZE; index++)
+			{
+				unsigned int uiSphereIndex = primitiveIndices[node.FirstPrimitive + index];
+
+				m_vSphereSlot[uiSphereIndex] = uiFirstSlot + index;
+				m_vSpheres[uiFirstSlot + index] = spheres[uiSphereIndex];
+
+				UpdateSphere(uiSphereIndex);
+			}
+		}
+	}
+
+	inline void Clear()
+	{
+		m_vStorage.clear();
+		m_vSpheres.clear();
+		m_vLeafBatch.clear();
+		m_vSphereSlot.clear();
+
+		m_uiSlotCount = 0;
+		m_pCenterX = m_pCenterY = m_pCenterZ = m_pSqRadius = nullptr;
+	}
+
+	// Reload a sphere after it moved, by its index in the list given to Build
+	inline void UpdateSphere(unsigned int uiSphereIndex)
+	{
+		unsigned int uiSlot = m_vSphereSlot[uiSphereIndex];
+		Sphere* pSphere = m_vSpheres[uiSlot];
+
+		glm::vec3 center = pSphere->GetCenter();
+		float fRadius = pSphere->GetRadius();
+
+		m_pCenterX[uiSlot] = center.x;
+		m_pCenterY[uiSlot] = center.y;
+		m_pCenterZ[uiSlot] = center.z;
+		m_pSqRadius[uiSlot] = fRadius * fRadius;
+	}
+
+	// ------------------------------------------------------------------------
+
+	// Closest sphere of the leaf hit in (0, tMax). Shrinks tMax to the hit
+	// distance and returns the sphere's slot, or -1 if none is hit.
+	inline int Intersect(const Ray& ray, int iLeafIndex, float& tMax) const
+	{
+		float distances[BATCH_SIZE];
+		unsigned int uiHitMask = BatchHitMask(ray, m_vLeafBatch[iLeafIndex] * BATCH_SIZE, tMax, distances);
+
+		int iClosestLane = -1;
+		for (unsigned int lane = 0; lane < BATCH_SIZE; lane++)
+		{
+			if ((uiHitMask & (1u << lane)) != 0 && distances[lane] < tMax)
+			{
+				tMax = distances[lane];
+				iClosestLane = (int)lane;
+			}
+		}
+
+		return (iClosestLane < 0) ? -1 : m_vLeafBatch[iLeafIndex] * (int)BATCH_SIZE + iClosestLane;
+	}
+
+	// Any sphere of the leaf other than the ignored object hit in (0, tMax)
+	inline bool Occluded(const Ray& ray, int iLeafIndex, float tMax, const Object* pIgnoredObject) const
+	{
+		float distances[BATCH_SIZE];
+		unsigned int uiFirstSlot = m_vLeafBatch[iLeafIndex] * BATCH_SIZE;
+		unsigned int uiHitMask = BatchHitMask(ray, uiFirstSlot, tMax, distances);
+
+		for (unsigned int lane = 0; uiHitMask != 0 && lane < BATCH_SIZE; lane++)
+		{
+			if ((uiHitMask & (1u << lane)) != 0 && m_vSpheres[uiFirstSlot + lane] != pIgnoredObject)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Full hit record of a slot returned by Intersect. Only the closest hit
+	// needs the point and the normal.
+	inline IntersectionInfo GetIntersection(const Ray& ray, int iSlot, float t) const
+	{
+		glm::vec3 center(m_pCenterX[iSlot], m_pCenterY[iSlot], m_pCenterZ[iSlot]);
+		glm::vec3 intersectionPoint = ray.GetOrigin() + t * ray.GetDirection();
+
+		return IntersectionInfo(intersectionPoint,
+			t,
+			glm::normalize(intersectionPoint - center),
+			m_vSpheres[iSlot]);
+	}
+
+	inline unsigned int SlotCount() const { return m_uiSlotCount; }
+
+private:
+	std::vector<float> m_vStorage;
+	unsigned int m_uiSlotCount = 0;
+
+	float* m_pCenterX = nullptr;
+	float* m_pCenterY = nullptr;
+	float* m_pCenterZ = nullptr;
+	float* m_pSqRadius = nullptr;
+
+	// Sphere of every slot, null in the unused ones
+	std::vector<Sphere*> m_vSpheres;
+
+	// Batch of every leaf node, -1 for inner nodes
+	std::vector<int> m_vLeafBatch;
+
+	// Slot of every sphere, by index in the list given to Build
+	std::vector<unsigned int> m_vSphereSlot;
+
+#ifdef SPHEREPOOL_AVX2
+	bool m_bAVX2 = false;
+#endif
+
+	// ------------------------------------------------------------------------
+
+	// Solve the ray/sphere quadratic for the slots of a batch. Returns a bit
+	// per slot hit in (0, tMax) and the hit distances. The steps are the ones
+	// of SolveQuadratic so the results match Sphere::FindIntersection.
+	inline unsigned int BatchHitMask(const Ray& ray, unsigned int uiFirstSlot, float tMax, float* pDistances) const
+	{
+#ifdef SPHEREPOOL_AVX2
+		if (m_bAVX2)
+		{
+			return BatchHitMaskAVX2(ray, uiFirstSlot, tMax, pDistances);
+		}
+#endif
+
+		typedef SphereLanes L;
+
+		const glm::vec3& origin = ray.GetOrigin();
+		const glm::vec3& direction = ray.GetDirection();
+
+		const L::Float originX = L::Set(origin.x);
+		const L::Float originY = L::Set(origin.y);
+		const L::Float originZ = L::Set(origin.z);
+		const L::Float directionX = L::Set(direction.x);
+		const L::Float directionY = L::Set(direction.y);
+		const L::Float directionZ = L::Set(direction.z);
+
+		const float fA = glm::dot(direction, direction);
+		const L::Float a = L::Set(fA);
+		const L::Float fourA = L::Set(4.0f * fA);
+		const L::Float zero = L::Set(0.0f);
+		const L::Float half = L::Set(-0.5f);
+		const L::Float two = L::Set(2.0f);
+		const L::Float maxDistance = L::Set(tMax);
+
+		unsigned int uiHitMask = 0;
+
+		for (unsigned int lane = 0; lane < BATCH_SIZE; lane += L::Width)
+		{
+			unsigned int uiSlot = uiFirstSlot + lane;
+
+			L::Float lx = L::Sub(originX, L::Load(m_pCenterX + uiSlot));
+			L::Float ly = L::Sub(originY, L::Load(m_pCenterY + uiSlot));
+			L::Float lz = L::Sub(originZ, L::Load(m_pCenterZ + uiSlot));
+
+			L::Float b = L::Mul(two, L::Add(L::Add(L::Mul(directionX, lx), L::Mul(directionY, ly)), L::Mul(directionZ, lz)));
+			L::Float c = L::Sub(L::Add(L::Add(L::Mul(lx, lx), L::Mul(ly, ly)), L::Mul(lz, lz)), L::Load(m_pSqRadius + uiSlot));
+
+			L::Float delta = L::Sub(L::Mul(b, b), L::Mul(fourA, c));
+			L::Mask solved = L::GreaterEqual(delta, zero);
+
+			// q = -0.5 * (b + sign(b) * sqrt(delta)), like SolveQuadratic
+			L::Float root = L::Sqrt(L::Max(delta, zero));
+			L::Float q = L::Mul(half, L::Add(b, L::Select(L::Greater(b, zero), root, L::Negate(root))));
+
+			L::Float x0 = L::Div(q, a);
+			L::Float x1 = L::Select(L::Equal(delta, zero), x0, L::Div(c, q));
+
+			// Use the far solution if the origin is inside the sphere
+			L::Float tNear = L::Min(x0, x1);
+			L::Float tFar = L::Max(x0, x1);
+			L::Float t = L::Select(L::Greater(tNear, zero), tNear, tFar);
+
+			L::Mask hit = L::And(solved, L::And(L::Greater(t, zero), L::Less(t, maxDistance)));
+
+			L::Store(pDistances + lane, t);
+			uiHitMask |= L::Bits(hit) << lane;
+		}
+
+		return uiHitMask;
+	}
+
+#ifdef SPHEREPOOL_AVX2
+	// The same steps on all the slots of the batch at once. The intrinsics
+	// are used directly: GCC and Clang can't inline lane helpers into a
+	// function built for another target.
+	CPU_TARGET_AVX2 unsigned int BatchHitMaskAVX2(const Ray& ray, unsigned int uiFirstSlot, float tMax, float* pDistances) const
+	{
+		static_assert(BATCH_SIZE == 8, "One AVX2 register per batch");
+
+		const glm::vec3& origin = ray.GetOrigin();
+		const glm::vec3& direction = ray.GetDirection();
+
+		const float fA = glm::dot(direction, direction);
+		const __m256 a = _mm256_set1_ps(fA);
+		const __m256 zero = _mm256_setzero_ps();
+
+		__m256 lx = _mm256_sub_ps(_mm256_set1_ps(origin.x), _mm256_load_ps(m_pCenterX + uiFirstSlot));
+		__m256 ly = _mm256_sub_ps(_mm256_set1_ps(origin.y), _mm256_load_ps(m_pCenterY + uiFirstSlot));
+		__m256 lz = _mm256_sub_ps(_mm256_set1_ps(origin.z), _mm256_load_ps(m_pCenterZ + uiFirstSlot));
+
+		__m256 dotDirection = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(direction.x), lx), _mm256_mul_ps(_mm256_set1_ps(direction.y), ly)), _mm256_mul_ps(_mm256_set1_ps(direction.z), lz));
+		__m256 b = _mm256_mul_ps(_mm256_set1_ps(2.0f), dotDirection);
+		__m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz)), _mm256_load_ps(m_pSqRadius + uiFirstSlot));
+
+		__m256 delta = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(_mm256_set1_ps(4.0f * fA), c));
+		__m256 solved = _mm256_cmp_ps(delta, zero, _CMP_GE_OQ);
+
+		__m256 root = _mm256_sqrt_ps(_mm256_max_ps(delta, zero));
+		__m256 signedRoot = _mm256_blendv_ps(_mm256_xor_ps(root, _mm256_set1_ps(-0.0f)), root, _mm256_cmp_ps(b, zero, _CMP_GT_OQ));
+		__m256 q = _mm256_mul_ps(_mm256_set1_ps(-0.5f), _mm256_add_ps(b, signedRoot));
+
+		__m256 x0 = _mm256_div_ps(q, a);
+		__m256 x1 = _mm256_blendv_ps(_mm256_div_ps(c, q), x0, _mm256_cmp_ps(delta, zero, _CMP_EQ_OQ));
+
+		__m256 tNear = _mm256_min_ps(x0, x1);
+		__m256 tFar = _mm256_max_ps(x0, x1);
+		__m256 t = _mm256_blendv_ps(tFar, tNear, _mm256_cmp_ps(tNear, zero, _CMP_GT_OQ));
+
+		__m256 inRange = _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ), _mm256_cmp_ps(t, _mm256_set1_ps(tMax), _CMP_LT_OQ));
+
+		_mm256_storeu_ps(pDistances, t);
+		return (unsigned int)_mm256_movemask_ps(_mm256_and_ps(solved, inRange));
+	}
+#endif
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __SPHEREPOOL_H__
\ No newline at end of file
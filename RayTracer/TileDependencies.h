@@ -0,0 +1,216 @@
+#ifndef __TILEDEPENDENCIES_H__
+#define __TILEDEPENDENCIES_H__
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <stdint.h>
+
+#include "Common.h"
+#include "Ray.h"
+#include "AABB.h"
+#include "Object.h"
+
+// ----------------------------------------------------------------------------
+
+// Conservative bounds of a set of rays: the box of their origins, the
+// interval of their directions on every axis and the longest of their
+// lengths. Every point a ray reached lies in the volume swept by these
+// bounds. The directions don't have to be normalized, e.g. segments can be
+// added as their origin, the vector to their end and a length of 1.
+struct RayBounds
+{
+	RayBounds()
+		: DirectionMin(std::numeric_limits<float>::infinity()),
+		DirectionMax(-std::numeric_limits<float>::infinity()),
+		MaxLength(0.0f)
+	{ }
+
+	inline bool Empty() const { return Origins.IsValid() == false; }
+
+	inline void Add(const glm::vec3& origin,
+		const glm::vec3& directionMin,
+		const glm::vec3& directionMax,
+		float fLength)
+	{
+		Origins.Extend(origin);
+		DirectionMin = glm::min(DirectionMin, directionMin);
+		DirectionMax = glm::max(DirectionMax, directionMax);
+		MaxLength = glm::max(MaxLength, fLength);
+	}
+
+	inline void Add(const Ray& ray, float fLength)
+	{
+		Add(ray.GetOrigin(), ray.GetDirection(), ray.GetDirection(), fLength);
+	}
+
+	// False only if none of the rays can have entered the box. On every axis
+	// the rays at t cover [Origins.Min + t * DirectionMin, Origins.Max + t *
+	// DirectionMax], which overlaps the box's slab for an interval of t.
+	inline bool MayReach(const AABB& box) const
+	{
+		if (Empty() == true || box.IsValid() == false)
+		{
+			return false;
+		}
+
+		float tEnter = 0.0f;
+		float tExit = MaxLength;
+
+		for (unsigned int uiAxis = 0; uiAxis < 3; uiAxis++)
+		{
+			// Lowest point at t not above the slab: t * DirectionMin <= fBelow
+			float fBelow = box.Max[uiAxis] - Origins.Min[uiAxis];
+			if (DirectionMin[uiAxis] > 0.0f)
+			{
+				tExit = glm::min(tExit, fBelow / DirectionMin[uiAxis]);
+			}
+			else if (DirectionMin[uiAxis] < 0.0f)
+			{
+				tEnter = glm::max(tEnter, fBelow / DirectionMin[uiAxis]);
+			}
+			else if (fBelow < 0.0f)
+			{
+				return false;
+			}
+
+			// Highest point at t not below the slab: t * DirectionMax >= fAbove
+			float fAbove = box.Min[uiAxis] - Origins.Max[uiAxis];
+			if (DirectionMax[uiAxis] > 0.0f)
+			{
+				tEnter = glm::max(tEnter, fAbove / DirectionMax[uiAxis]);
+			}
+			else if (DirectionMax[uiAxis] < 0.0f)
+			{
+				tExit = glm::min(tExit, fAbove / DirectionMax[uiAxis]);
+			}
+			else if (fAbove > 0.0f)
+			{
+				return false;
+			}
+		}
+
+		return tEnter <= tExit;
+	}
+
+	AABB Origins;
+	glm::vec3 DirectionMin;
+	glm::vec3 DirectionMax;
+
+	// Infinity once a ray left the scene
+	float MaxLength;
+};
+
+// ----------------------------------------------------------------------------
+
+// What the rays of one screen tile depended on in the frame which traced
+// them: the objects they hit, and the bounds of the bounces and shadow rays,
+// split by direction octant so each set stays narrow. When objects only move, a tile whose rays neither
+// hit a moved object nor can reach it at its new position (nor, for shadow
+// rays, at its old one) would be traced exactly as before.
+class TileDependencies
+{
+public:
+	inline void Clear()
+	{
+		m_vHitObjects.clear();
+
+		for (unsigned int uiOctant = 0; uiOctant < 8; uiOctant++)
+		{
+			m_Bounces[uiOctant] = RayBounds();
+			m_ShadowRays[uiOctant] = RayBounds();
+		}
+
+		m_ShadowSegments = RayBounds();
+	}
+
+	// One bit per object index
+	inline void AddHit(const Object* pObject)
+	{
+		if (pObject == nullptr)
+		{
+			return;
+		}
+
+		unsigned int uiWord = pObject->GetIndex() / 32;
+		if (uiWord >= m_vHitObjects.size())
+		{
+			m_vHitObjects.resize(uiWord + 1, 0);
+		}
+
+		m_vHitObjects[uiWord] |= 1u << (pObject->GetIndex() % 32);
+	}
+
+	// Closest hit query, e.g. a reflected or refracted ray
+	inline void AddRay(const Ray& ray, const IntersectionInfo& intersect)
+	{
+		AddHit(intersect.HitObject);
+
+		float fLength = (intersect.HitObject != nullptr) ? intersect.RayLength : std::numeric_limits<float>::infinity();
+		m_Bounces[Octant(ray)].Add(ray, fLength);
+	}
+
+	// Any hit query up to tMax, whatever its result
+	inline void AddShadowRay(const Ray& ray, float tMax)
+	{
+		m_ShadowRays[Octant(ray)].Add(ray, tMax);
+	}
+
+	// Any hit queries from the origin to points of the box, e.g. the samples
+	// of an area light, added at once
+	inline void AddShadowRays(const glm::vec3& origin, const AABB& targets)
+	{
+		m_ShadowSegments.Add(origin, targets.Min - origin, targets.Max - origin, 1.0f);
+	}
+
+	inline bool Hit(const Object* pObject) const
+	{
+		unsigned int uiWord = pObject->GetIndex() / 32;
+		return uiWord < m_vHitObjects.size() &&
+			(m_vHitObjects[uiWord] & (1u << (pObject->GetIndex() % 32))) != 0;
+	}
+
+	inline bool BouncesMayReach(const AABB& box) const
+	{
+		for (unsigned int uiOctant = 0; uiOctant < 8; uiOctant++)
+		{
+			if (m_Bounces[uiOctant].MayReach(box))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline bool ShadowRaysMayReach(const AABB& box) const
+	{
+		for (unsigned int uiOctant = 0; uiOctant < 8; uiOctant++)
+		{
+			if (m_ShadowRays[uiOctant].MayReach(box))
+			{
+				return true;
+			}
+		}
+		return m_ShadowSegments.MayReach(box);
+	}
+
+private:
+	std::vector<uint32_t> m_vHitObjects;
+
+	RayBounds m_Bounces[8];
+	RayBounds m_ShadowRays[8];
+	RayBounds m_ShadowSegments;
+
+	// The sign of zero counts too, like in RayPacket
+	static inline unsigned int Octant(const Ray& ray)
+	{
+		const glm::vec3& direction = ray.GetDirection();
+		return (std::signbit(direction.x) ? 1u : 0u) |
+			(std::signbit(direction.y) ? 2u : 0u) |
+			(std::signbit(direction.z) ? 4u : 0u);
+	}
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __TILEDEPENDENCIES_H__
\ No newline at end of file
@@ -0,0 +1,197 @@
+// -----------------------------------------------------------------------
+
+#include "TileScheduler.h"
+
+#include <algorithm>
+
+// -----------------------------------------------------------------------
+
+TileScheduler::TileScheduler(unsigned int uiWorkerCount)
+	: m_uiRemainingTiles(0)
+{
+	if (uiWorkerCount == 0)
+	{
+		// hardware_concurrency may return 0 when it can't tell
+		uiWorkerCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	for (unsigned int index = 0; index < uiWorkerCount; index++)
+	{
+		m_vQueues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+	}
+
+	for (unsigned int index = 0; index < uiWorkerCount; index++)
+	{
+		m_vWorkers.push_back(std::thread(&TileScheduler::WorkerLoop, this, index));
+	}
+}
+
+// -----------------------------------------------------------------------
+
+TileScheduler::~TileScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_FrameMutex);
+		m_bShutdown = true;
+	}
+	m_FrameStart.notify_all();
+
+	for (std::thread& worker : m_vWorkers)
+	{
+		worker.join();
+	}
+}
+
+// -----------------------------------------------------------------------
+
+void TileScheduler::SetupTiles(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiTileSize)
+{
+	m_vTiles.clear();
+
+	for (unsigned int y = 0; y < uiHeight; y += uiTileSize)
+	{
+		for (unsigned int x = 0; x < uiWidth; x += uiTileSize)
+		{
+			Tile tile;
+			tile.StartX = x;
+			tile.StartY = y;
+			tile.EndX = std::min(x + uiTileSize, uiWidth);
+			tile.EndY = std::min(y + uiTileSize, uiHeight);
+
+			m_vTiles.push_back(tile);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------
+
+void TileScheduler::Run(const TileTask& task)
+{
+	if (m_vTiles.empty())
+	{
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(m_FrameMutex);
+
+		// Workers which woke up late for the previous frame must be done before
+		// the queues are refilled
+		m_FrameDone.wait(lock, [&]() { return m_uiActiveWorkers == 0; });
+
+		m_CurrentTask = task;
+
+		// Give every worker a contiguous range of tiles, neighbouring tiles
+		// tend to have a similar cost and share the same part of the scene
+		unsigned int uiTileCount = (unsigned int)m_vTiles.size();
+		unsigned int uiWorkerCount = (unsigned int)m_vQueues.size();
+
+		for (unsigned int worker = 0; worker < uiWorkerCount; worker++)
+		{
+			unsigned int uiStart = (unsigned int)((unsigned long long)uiTileCount * worker / uiWorkerCount);
+			unsigned int uiEnd = (unsigned int)((unsigned long long)uiTileCount * (worker + 1) / uiWorkerCount);
+
+			std::lock_guard<std::mutex> queueLock(m_vQueues[worker]->Mutex);
+			m_vQueues[worker]->Tiles.clear();
+			for (unsigned int tile = uiStart; tile < uiEnd; tile++)
+			{
+				m_vQueues[worker]->Tiles.push_back(tile);
+			}
+		}
+
+		m_uiRemainingTiles = uiTileCount;
+		m_ullFrameIndex++;
+	}
+
+	m_FrameStart.notify_all();
+
+	// Wait for the last tile and for the workers to go back to sleep
+	std::unique_lock<std::mutex> lock(m_FrameMutex);
+	m_FrameDone.wait(lock, [&]() { return m_uiRemainingTiles == 0 && m_uiActiveWorkers == 0; });
+}
+
+// -----------------------------------------------------------------------
+
+void TileScheduler::WorkerLoop(unsigned int uiWorkerIndex)
+{
+	unsigned long long ullLastFrame = 0;
+
+	while (true)
+	{
+		TileTask task;
+
+		// Wait for a new frame
+		{
+			std::unique_lock<std::mutex> lock(m_FrameMutex);
+			m_FrameStart.wait(lock, [&]() { return m_bShutdown || m_ullFrameIndex != ullLastFrame; });
+
+			if (m_bShutdown)
+			{
+				return;
+			}
+
+			ullLastFrame = m_ullFrameIndex;
+			task = m_CurrentTask;
+			m_uiActiveWorkers++;
+		}
+
+		// Process the own tiles first, then help the other workers
+		unsigned int uiTileIndex;
+		while (PopTile(uiWorkerIndex, uiTileIndex) || StealTile(uiWorkerIndex, uiTileIndex))
+		{
+			task(m_vTiles[uiTileIndex]);
+
+			m_uiRemainingTiles--;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_FrameMutex);
+			m_uiActiveWorkers--;
+		}
+		m_FrameDone.notify_all();
+	}
+}
+
+// -----------------------------------------------------------------------
+
+bool TileScheduler::PopTile(unsigned int uiWorkerIndex, unsigned int& uiTileIndex)
+{
+	WorkerQueue& queue = *m_vQueues[uiWorkerIndex];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+
+	if (queue.Tiles.empty())
+	{
+		return false;
+	}
+
+	uiTileIndex = queue.Tiles.front();
+	queue.Tiles.pop_front();
+
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool TileScheduler::StealTile(unsigned int uiWorkerIndex, unsigned int& uiTileIndex)
+{
+	unsigned int uiWorkerCount = (unsigned int)m_vQueues.size();
+
+	// Steal from the back of the other queues, the owner works from the front
+	for (unsigned int offset = 1; offset < uiWorkerCount; offset++)
+	{
+		WorkerQueue& queue = *m_vQueues[(uiWorkerIndex + offset) % uiWorkerCount];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+
+		if (queue.Tiles.empty() == false)
+		{
+			uiTileIndex = queue.Tiles.back();
+			queue.Tiles.pop_back();
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// -----------------------------------------------------------------------
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef __TILESCHEDULER_H__
+#define __TILESCHEDULER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+
+// Rectangle of pixels [StartX, EndX) x [StartY, EndY)
+struct Tile
+{
+	unsigned int StartX;
+	unsigned int StartY;
+	unsigned int EndX;
+	unsigned int EndY;
+};
+
+// ----------------------------------------------------------------------------
+
+// Splits the image into small tiles and renders them on a pool of worker
+// threads. Every worker starts with its own contiguous share of the tiles and
+// steals from the other workers once it runs out, so the frame finishes when
+// the total work is done rather than when the most expensive band is done.
+class TileScheduler
+{
+public:
+	typedef std::function<void(const Tile&)> TileTask;
+
+	// A worker count of 0 uses one worker per hardware thread
+	TileScheduler(unsigned int uiWorkerCount = 0);
+	~TileScheduler();
+
+	// Split the image in tiles of the given size. The tiles on the right and
+	// bottom edge are clipped to the image.
+	void SetupTiles(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiTileSize);
+
+	// Run the task on every tile and wait until all of them are finished
+	void Run(const TileTask& task);
+
+	inline unsigned int GetWorkerCount() const { return (unsigned int)m_vWorkers.size(); }
+	inline const std::vector<Tile>& GetTiles() const { return m_vTiles; }
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex Mutex;
+		std::deque<unsigned int> Tiles;
+	};
+
+	std::vector<std::thread> m_vWorkers;
+	std::vector<std::unique_ptr<WorkerQueue>> m_vQueues;
+	std::vector<Tile> m_vTiles;
+
+	// Current frame
+	TileTask m_CurrentTask;
+	unsigned long long m_ullFrameIndex = 0;
+	std::atomic<unsigned int> m_uiRemainingTiles;
+	unsigned int m_uiActiveWorkers = 0;
+	bool m_bShutdown = false;
+
+	std::mutex m_FrameMutex;
+	std::condition_variable m_FrameStart;
+	std::condition_variable m_FrameDone;
+
+	void WorkerLoop(unsigned int uiWorkerIndex);
+	bool PopTile(unsigned int uiWorkerIndex, unsigned int& uiTileIndex);
+	bool StealTile(unsigned int uiWorkerIndex, unsigned int& uiTileIndex);
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // __TILESCHEDULER_H__
\ No newline at end of file
@@ -26,69 +26,64 @@ public:
 	inline const glm::vec3& GetP2() const { return m_vP2; }
 	inline const glm::vec3& GetP3() const { return m_vP3; }
 
-	inline bool RayPlaneIntersect(const Ray& ray,
-		const glm::vec3& normal,
-		float& t)
-	{
-		float normalDotDir = glm::dot(normal, ray.GetDirection());
-		if (normalDotDir > Constants::EPS)
-		{
-			glm::vec3 v = m_vP1 - ray.GetOrigin();
-			t = glm::dot(v, normal) / normalDotDir;
+private:
 
-			return (t >= 0.0f);
-		}
+	glm::vec3 m_vP1;
+	glm::vec3 m_vP2;
+	glm::vec3 m_vP3;
+};
 
-		return false;
-	}
+// ----------------------------------------------------------------------------
 
-	inline bool RayTriangleIntersect(const Ray& ray, 
-		glm::vec3& normal,
-		glm::vec3& intersectionPoint, 
-		float& rayLength)
+// Triangle prepared for ray tests. The edges only change when the owner
+// rebuilds its triangles, so they are computed once there instead of on
+// every test.
+struct TriangleRecord
+{
+	TriangleRecord(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3)
+		: V0(p1), E1(p2 - p1), E2(p3 - p1)
+	{ }
+
+	// Moller-Trumbore test against both sides of the triangle. The direction
+	// doesn't have to be unit length, t is measured in its units. u and v are
+	// the barycentric coordinates of the second and third vertex.
+	inline bool Intersect(const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& t,
+		float& u,
+		float& v) const
 	{
-		// Calculate triangle's edges
-		glm::vec3 p1p2 = m_vP2 - m_vP1;
-		glm::vec3 p1p3 = m_vP3 - m_vP1;
-
-		// Calculate plane's normal
-		normal = glm::normalize(glm::cross(p1p2, p1p3));
-
-		if (RayPlaneIntersect(ray, normal, rayLength) == true)
+		glm::vec3 p = glm::cross(direction, E2);
+		float fDeterminant = glm::dot(E1, p);
+		if (fDeterminant == 0.0f)
 		{
-			intersectionPoint = ray.GetOrigin() + rayLength * ray.GetDirection();
-
-			// Check if the intersection point is inside the triangle
-
-			// Edge 1
-			glm::vec3 edge1 = m_vP2 - m_vP1;
-			glm::vec3 p1IntersectionPoint = intersectionPoint - m_vP1;
-			glm::vec3 c1 = glm::cross(edge1, p1IntersectionPoint);
-			if (glm::dot(normal, c1) < 0.0f) return false;
+			// The ray is parallel to the triangle
+			return false;
+		}
 
-			// Edge 2
-			glm::vec3 edge2 = m_vP3 - m_vP2;
-			glm::vec3 p2IntersectionPoint = intersectionPoint - m_vP2;
-			glm::vec3 c2 = glm::cross(edge2, p2IntersectionPoint);
-			if (glm::dot(normal, c2) < 0.0f) return false;
+		float fInvDeterminant = 1.0f / fDeterminant;
 
-			// Edge 3
-			glm::vec3 edge3 = m_vP1 - m_vP3;
-			glm::vec3 p3IntersectionPoint = intersectionPoint - m_vP3;
-			glm::vec3 c3 = glm::cross(edge3, p3IntersectionPoint);
-			if (glm::dot(normal, c3) < 0.0f) return false;
+		glm::vec3 s = origin - V0;
+		u = glm::dot(s, p) * fInvDeterminant;
+		if (u < 0.0f || u > 1.0f)
+		{
+			return false;
+		}
 
-			return true;
+		glm::vec3 q = glm::cross(s, E1);
+		v = glm::dot(direction, q) * fInvDeterminant;
+		if (v < 0.0f || u + v > 1.0f)
+		{
+			return false;
 		}
 
-		return false;
+		t = glm::dot(E2, q) * fInvDeterminant;
+		return true;
 	}
 
-private:
-
-	glm::vec3 m_vP1;
-	glm::vec3 m_vP2;
-	glm::vec3 m_vP3;
+	glm::vec3 V0;
+	glm::vec3 E1;
+	glm::vec3 E2;
 };
 
 // ----------------------------------------------------------------------------
@@ -11,6 +11,7 @@ UI::UI(Scene* scene,
 	float* sampleDistance,
 	bool* updateRequired,
 	bool* Realtime,
+	bool* ProgressiveEnabled,
 	bool* ShadowsEnabled,
 	bool* SoftShadowsEnabled,
 	bool* SuperSamplingEnabled,
@@ -27,6 +28,7 @@ UI::UI(Scene* scene,
 	m_pfSampleDistance(sampleDistance),
 	m_bUpdateRequired(updateRequired), 
 	m_bRealtime(Realtime),
+	m_bProgressive(ProgressiveEnabled),
 	m_bShadows(ShadowsEnabled), 
 	m_bSoftShadows(SoftShadowsEnabled), 
 	m_bSuperSampling(SuperSamplingEnabled),
@@ -117,6 +119,16 @@ void UI::LoadUIElements()
 	if (*m_bRealtime) { realtimeCheckbox->check(); }
 	realtimeCheckbox->bindCallbackEx(&UI::checkBoxCallback, this, tgui::Checkbox::Checked | tgui::Checkbox::Unchecked);
 
+	// Progressive checkbox
+	tgui::Checkbox::Ptr progressiveCheckbox(m_GUI);
+	progressiveCheckbox->load("lib//TGUI//widgets//Black.conf");
+	progressiveCheckbox->setPosition(140, m_fTopAlign);
+	progressiveCheckbox->setText("Progressive");
+	progressiveCheckbox->setSize(m_fRowHeight, m_fRowHeight);
+	progressiveCheckbox->setCallbackId(CheckboxType::Progressive);
+	if (*m_bProgressive) { progressiveCheckbox->check(); }
+	progressiveCheckbox->bindCallbackEx(&UI::checkBoxCallback, this, tgui::Checkbox::Checked | tgui::Checkbox::Unchecked);
+
 	// ------------------------------------------------------------------------
 
 	// Shadows checkbox
@@ -276,6 +288,7 @@ void UI::LoadUIElements()
 	objectTypeSelectionComboBox->addItem("Sphere");
 	objectTypeSelectionComboBox->addItem("Area Light");
 	objectTypeSelectionComboBox->addItem("Box");
+	objectTypeSelectionComboBox->addItem("Mesh Instance");
 	objectTypeSelectionComboBox->setSelectedItem(0);
 
 	// Add object to scene button
@@ -428,7 +441,15 @@ void UI::Update()
 
 		if (pSelectedObject != NULL)
 		{
-			pSelectedObject->SetPosition(glm::vec3(xPos / 50.0f, yPos / 50.0f, zPos / 50.0f));
+			glm::vec3 newPosition = glm::vec3(xPos / 50.0f, yPos / 50.0f, zPos / 50.0f);
+
+			if (pSelectedObject->GetPosition() != newPosition)
+			{
+				pSelectedObject->SetPosition(newPosition);
+
+				// Only the object's leaf of the scene hierarchy has to be refitted
+				m_pScene->MarkObjectMoved(pSelectedObject);
+			}
 		}
 	}
 }
@@ -445,6 +466,12 @@ void UI::checkBoxCallback(const tgui::Callback& callback)
 
 			break;
 		}
+		case CheckboxType::Progressive:
+		{
+			*m_bProgressive = !(*m_bProgressive);
+
+			break;
+		}
 		case CheckboxType::Shadows:
 		{
 			*m_bShadows = !(*m_bShadows);
@@ -597,6 +624,25 @@ void UI::addObjectCallback(const tgui::Callback& callback)
 			m_pScene->AddObject(new Box());
 			break;
 		}
+
+		case ObjectToAdd::MeshInstanceObj:
+		{
+			// Copy of the selected mesh next to it, sharing its triangles
+			int iSelectedIndex = comboBox->getSelectedItemIndex();
+			if (iSelectedIndex != -1 && m_ObjecList[iSelectedIndex]->Type() == ObjectType::keMESH)
+			{
+				MeshInstance* pSelectedMesh = static_cast<MeshInstance*>(m_ObjecList[iSelectedIndex]);
+
+				glm::mat4x3 transform = pSelectedMesh->GetTransform();
+				transform[3] += glm::vec3(1.0f, 0.0f, 0.0f);
+
+				m_pScene->AddObject(new MeshInstance(pSelectedMesh->GetMaterial(),
+					pSelectedMesh->GetGeometry(),
+					transform,
+					pSelectedMesh->GetName() + "Copy"));
+			}
+			break;
+		}
 		
 		default:
 			break;
@@ -7,24 +7,20 @@
 #include "TGUI/TGUI.hpp"
 
 #include "Scene.h"
+#include "Renderer.h"
 #include "Object.h"
 
 #include "PointLight.h"
 #include "DirectionalLight.h"
 #include "Sphere.h"
-#include "Triangle.h"
+#include "Mesh.h"
 
 class UI
 {
 public:
 
-	enum LightingModel
-	{
-		Phong = 0,
-		BlinnPhong,
-
-		InvalidLightModel,
-	};
+	// Shared with the renderer
+	typedef ::LightingModel LightingModel;
 
 	UI(Scene* scene,
 		unsigned int* reflectionDepth,
@@ -35,6 +31,7 @@ public:
 		float* sampleDistance,
 		bool* updateRequired,
 		bool* Realtime,
+		bool* ProgressiveEnabled,
 		bool* ShadowsEnabled,
 		bool* SoftShadowsEnabled,
 		bool* SuperSamplingEnabled,
@@ -54,6 +51,7 @@ private:
 	enum CheckboxType
 	{
 		Realtime = 0,
+		Progressive,
 		Shadows,
 		SoftShadows,
 		SuperSampling,
@@ -71,6 +69,7 @@ private:
 		SphereObj,
 		AreaLightObj,
 		BoxObj,
+		MeshInstanceObj,
 
 		InvalidObjectType,
 	};
@@ -91,6 +90,7 @@ private:
 	float* m_pfSampleDistance;
 
 	bool* m_bRealtime;
+	bool* m_bProgressive;
 	bool* m_bUpdateRequired;
 	bool* m_bShadows;
 	bool* m_bSoftShadows;